@@ -0,0 +1,380 @@
+/*
+  ==============================================================================
+
+    AllocationCheck.cpp
+    Created: 17 Oct 2026 2:26:13pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+#include "AllocationCheck.h"
+#include "../../Source/PluginProcessor.h"
+#include <cstdlib>
+#include <new>
+
+//==============================================================================
+// Allocation counter shared with the replaced allocator below. Nothing in here may allocate.
+namespace
+{
+    // set around processBlock on the thread that calls it, so the loader and page warmer threads
+    // can allocate as they please while a block runs
+    thread_local bool armed = false;
+    std::atomic<bool> breakOnAllocation { false };
+    std::atomic<int> allocations { 0 };
+    std::atomic<int> deallocations { 0 };
+
+    void noteAllocation()
+    {
+        if (! armed)
+            return;
+
+        allocations.fetch_add (1, std::memory_order_relaxed);
+
+        if (breakOnAllocation.load (std::memory_order_relaxed))
+            JUCE_BREAK_IN_DEBUGGER;
+    }
+
+    void noteDeallocation (void* pointer)
+    {
+        if (pointer == nullptr || ! armed)
+            return;
+
+        deallocations.fetch_add (1, std::memory_order_relaxed);
+
+        if (breakOnAllocation.load (std::memory_order_relaxed))
+            JUCE_BREAK_IN_DEBUGGER;
+    }
+}
+
+#if JUCE_LINUX && defined (__GLIBC__)
+ // HeapBlock and AudioBuffer go straight to malloc, so on glibc the C allocator is replaced too
+ extern "C"
+ {
+     void* __libc_malloc (size_t);
+     void* __libc_calloc (size_t, size_t);
+     void* __libc_realloc (void*, size_t);
+     void __libc_free (void*);
+
+     void* malloc (size_t size)                    { noteAllocation(); return __libc_malloc (size); }
+     void* calloc (size_t num, size_t size)        { noteAllocation(); return __libc_calloc (num, size); }
+     void* realloc (void* pointer, size_t size)    { noteAllocation(); return __libc_realloc (pointer, size); }
+     void free (void* pointer)                     { noteDeallocation (pointer); __libc_free (pointer); }
+ }
+
+ static void* rawAllocate (size_t size)            { return __libc_malloc (size); }
+ static void rawFree (void* pointer)               { __libc_free (pointer); }
+#else
+ static void* rawAllocate (size_t size)            { return std::malloc (size); }
+ static void rawFree (void* pointer)               { std::free (pointer); }
+#endif
+
+static void* allocate (size_t size)
+{
+    noteAllocation();
+    return rawAllocate (size == 0 ? 1 : size);
+}
+
+static void* allocateAligned (size_t size, std::align_val_t alignment)
+{
+    noteAllocation();
+    void* pointer = nullptr;
+
+    if (posix_memalign (&pointer, juce::jmax (sizeof (void*), (size_t) alignment), size == 0 ? 1 : size) != 0)
+        return nullptr;
+
+    return pointer;
+}
+
+static void deallocate (void* pointer)
+{
+    noteDeallocation (pointer);
+    rawFree (pointer);
+}
+
+void* operator new (size_t size)
+{
+    if (auto* pointer = allocate (size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)
+{
+    if (auto* pointer = allocate (size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (size_t size, std::align_val_t alignment)
+{
+    if (auto* pointer = allocateAligned (size, alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size, std::align_val_t alignment)
+{
+    if (auto* pointer = allocateAligned (size, alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (size_t size, const std::nothrow_t&) noexcept                                  { return allocate (size); }
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept                                { return allocate (size); }
+void* operator new (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept      { return allocateAligned (size, alignment); }
+void* operator new[] (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept    { return allocateAligned (size, alignment); }
+
+// posix_memalign memory is released with free() on every platform this target builds for
+void operator delete (void* pointer) noexcept                                                     { deallocate (pointer); }
+void operator delete[] (void* pointer) noexcept                                                   { deallocate (pointer); }
+void operator delete (void* pointer, size_t) noexcept                                             { deallocate (pointer); }
+void operator delete[] (void* pointer, size_t) noexcept                                           { deallocate (pointer); }
+void operator delete (void* pointer, std::align_val_t) noexcept                                   { deallocate (pointer); }
+void operator delete[] (void* pointer, std::align_val_t) noexcept                                 { deallocate (pointer); }
+void operator delete (void* pointer, size_t, std::align_val_t) noexcept                           { deallocate (pointer); }
+void operator delete[] (void* pointer, size_t, std::align_val_t) noexcept                         { deallocate (pointer); }
+void operator delete (void* pointer, const std::nothrow_t&) noexcept                              { deallocate (pointer); }
+void operator delete[] (void* pointer, const std::nothrow_t&) noexcept                            { deallocate (pointer); }
+
+//==============================================================================
+namespace
+{
+    // the longest block of the script, as a multiple of the prepared block size
+    constexpr int maxOversize = 4;
+
+    // choices that switch the audio thread onto different code, tried in every combination with each other
+    const char* const crossedParameters[] = { "Mode", "Interpolation", "Scheduling", "ReverbOn" };
+
+    struct ScriptBlock
+    {
+        int numSamples;
+        juce::MidiBuffer midi;
+    };
+
+    /**
+     a short performance played for every parameter setting tried: overlapping notes, a steal,
+     releases with and without the sustain pedal, all-notes-off, and awkward block sizes - including
+     blocks longer than the prepared one, which hosts are allowed to send
+     */
+    std::vector<ScriptBlock> makeScript (int blockSize)
+    {
+        const int sizes[] = { blockSize, blockSize, 1, 37, blockSize / 2, blockSize - 1, blockSize * 2 + 3, blockSize * maxOversize };
+
+        std::vector<ScriptBlock> script (24);
+        for (size_t b = 0; b < script.size(); ++b)
+            script[b].numSamples = juce::jmax (1, sizes[b % juce::numElementsInArray (sizes)]);
+
+        auto at = [&] (size_t b, const juce::MidiMessage& message, float position)
+        {
+            script[b].midi.addEvent (message, juce::jlimit (0, script[b].numSamples - 1, int (position * float (script[b].numSamples))));
+        };
+
+        at (0, juce::MidiMessage::noteOn (1, 60, 1.0f), 0.0f);
+        at (0, juce::MidiMessage::noteOn (1, 64, 0.8f), 0.5f);
+        at (2, juce::MidiMessage::noteOn (1, 67, 0.6f), 0.0f);
+        at (3, juce::MidiMessage::noteOn (1, 71, 1.0f), 0.3f); // one more than there are voices
+        at (5, juce::MidiMessage::noteOff (1, 60), 0.7f);
+        at (8, juce::MidiMessage::noteOn (1, 60, 0.9f), 0.25f);
+        at (12, juce::MidiMessage::controllerEvent (1, 64, 127), 0.0f);
+        at (12, juce::MidiMessage::noteOff (1, 64), 0.5f);
+        at (12, juce::MidiMessage::noteOff (1, 67), 0.9f);
+        at (14, juce::MidiMessage::controllerEvent (1, 64, 0), 0.5f);
+        at (16, juce::MidiMessage::allNotesOff (1), 0.5f);
+        at (18, juce::MidiMessage::noteOn (1, 62, 0.7f), 0.1f);
+        at (22, juce::MidiMessage::noteOff (1, 62), 0.6f);
+        at (22, juce::MidiMessage::noteOff (1, 71), 0.8f);
+        at (23, juce::MidiMessage::noteOff (1, 60), 0.0f);
+        return script;
+    }
+
+    /**
+     normalised values tried for one parameter on its own: every step of a choice, int or bool
+     parameter with a handful of values, otherwise both ends of the range
+     */
+    juce::Array<float> valuesToTry (const juce::RangedAudioParameter& param)
+    {
+        juce::Array<float> values;
+        const int numSteps = param.getNumSteps();
+
+        if (param.isDiscrete() && numSteps <= 16)
+        {
+            for (int step = 0; step < numSteps; ++step)
+                values.add (float (step) / float (juce::jmax (1, numSteps - 1)));
+        }
+        else
+        {
+            values.add (0.0f);
+            values.add (1.0f);
+        }
+
+        return values;
+    }
+
+    /**
+     writes a quarter of a second of a sine for the sample swaps
+     @return false if the file couldn't be written
+     */
+    bool writeSwapFile (const juce::File& file, float frequency)
+    {
+        constexpr double sampleRate = 48000.0;
+        juce::AudioBuffer<float> buffer (2, (int) sampleRate / 4);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * frequency * float (i) / float (sampleRate)));
+
+        juce::WavAudioFormat wav;
+        file.deleteFile();
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (new juce::FileOutputStream (file), sampleRate,
+                                                                              (unsigned int) buffer.getNumChannels(), 24, {}, 0));
+        return writer != nullptr && writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    juce::String describe (const juce::Array<juce::RangedAudioParameter*>& params)
+    {
+        juce::StringArray settings;
+        for (auto* param : params)
+            settings.add (param->paramID + "=" + param->getCurrentValueAsText());
+
+        return settings.joinIntoString (" ");
+    }
+}
+
+//==============================================================================
+int runAllocationCheck (const juce::ArgumentList& args)
+{
+    const double sampleRate = 48000.0;
+    const int blockSize = args.containsOption ("--block") ? args.getValueForOption ("--block").getIntValue() : 512;
+    const int numCombinations = args.containsOption ("--combinations") ? args.getValueForOption ("--combinations").getIntValue() : 200;
+    const int seed = args.containsOption ("--seed") ? args.getValueForOption ("--seed").getIntValue() : 1;
+    breakOnAllocation = args.containsOption ("--break");
+
+    TryGranulatorAudioProcessor processor;
+
+    juce::Array<juce::RangedAudioParameter*> params;
+    for (auto* param : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (param))
+            params.add (ranged);
+
+    // two samples to swap between halfway through every run of the script
+    juce::TemporaryFile firstSwap (".wav"), secondSwap (".wav");
+    const juce::File swapFiles[] = { firstSwap.getFile(), secondSwap.getFile() };
+
+    if (! writeSwapFile (swapFiles[0], 220.0f) || ! writeSwapFile (swapFiles[1], 330.0f))
+    {
+        std::cout << "can't write the samples to swap" << std::endl;
+        return 1;
+    }
+
+    processor.setPlayConfigDetails (0, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    auto script = makeScript (blockSize);
+    juce::AudioBuffer<float> buffer (2, blockSize * maxOversize);
+    juce::Random random (seed);
+    int numFailed = 0, numRun = 0;
+
+    // plays the script with the current settings; the counter is only armed around processBlock.
+    // Halfway through, the next sample is loaded so the block after picks it up with acquireLatest
+    // while voices are still playing the old one
+    auto play = [&]
+    {
+        allocations = 0;
+        deallocations = 0;
+
+        for (size_t b = 0; b < script.size(); ++b)
+        {
+            if (b == script.size() / 2)
+            {
+                processor.loadSample (swapFiles[numRun % 2].getFullPathName());
+
+                if (! processor.waitForSampleLoad (10000) || processor.didSampleLoadFail())
+                    std::cout << "couldn't load the sample to swap in" << std::endl;
+            }
+
+            auto& block = script[b];
+            buffer.setSize (2, block.numSamples, false, false, true);
+
+            armed = true;
+            processor.processBlock (buffer, block.midi);
+            armed = false;
+        }
+
+        ++numRun;
+
+        if (allocations.load() == 0 && deallocations.load() == 0)
+            return;
+
+        ++numFailed;
+        std::cout << "ALLOCATED  " << allocations.load() << " new, " << deallocations.load() << " delete  "
+                  << (processor.isNonRealtime() ? "offline" : "realtime") << "  with  " << describe (params) << std::endl;
+    };
+
+    juce::Array<juce::RangedAudioParameter*> crossed;
+    for (auto* param : params)
+        for (auto* paramID : crossedParameters)
+            if (param->paramID == paramID)
+                crossed.add (param);
+
+    // once as an offline render, and once in realtime, where GrainBudget times the blocks and thins the cloud
+    for (bool nonRealtime : { true, false })
+    {
+        processor.setNonRealtime (nonRealtime);
+
+        // every parameter on its own, the rest at their defaults
+        for (auto* param : params)
+        {
+            for (float value : valuesToTry (*param))
+            {
+                for (auto* other : params)
+                    other->setValueNotifyingHost (other == param ? value : other->getDefaultValue());
+
+                play();
+            }
+        }
+
+        // every combination of the choices in crossedParameters, the rest at their defaults
+        juce::Array<int> steps;
+        steps.insertMultiple (0, 0, crossed.size());
+
+        for (bool done = false; ! done;)
+        {
+            for (auto* param : params)
+                param->setValueNotifyingHost (param->getDefaultValue());
+
+            for (int i = 0; i < crossed.size(); ++i)
+                crossed[i]->setValueNotifyingHost (valuesToTry (*crossed[i])[steps[i]]);
+
+            play();
+
+            // next combination, counting through the steps like the digits of a number
+            done = true;
+            for (int i = 0; i < crossed.size() && done; ++i)
+            {
+                if (++steps.getReference (i) < valuesToTry (*crossed[i]).size())
+                    done = false;
+                else
+                    steps.set (i, 0);
+            }
+        }
+
+        // then everything at once
+        for (int i = 0; i < numCombinations; ++i)
+        {
+            for (auto* param : params)
+                param->setValueNotifyingHost (random.nextFloat());
+
+            play();
+        }
+    }
+
+    processor.releaseResources();
+
+    std::cout << numRun << " parameter combinations, " << numFailed << " allocated on the audio thread" << std::endl;
+    return numFailed == 0 ? 0 : 1;
+}
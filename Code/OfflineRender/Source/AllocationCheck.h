@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    AllocationCheck.h
+    Created: 17 Oct 2026 2:26:13pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/**
+ Checks that processBlock never touches the heap.
+
+    OfflineRender --alloc-check [--combinations 200] [--seed 1] [--block 512] [--break]
+
+ The global allocator (operator new/delete, and malloc/free on Linux) is replaced for the whole
+ program and counts every call made on the thread running processBlock while it runs - the sample
+ loader and page warmer threads are left alone. Voices handed to the workers by ParallelVoices
+ aren't counted, but they run the same code the calling thread runs with it off, its default.
+ The processor is prepared once and then played through every parameter on its own at its
+ extremes and every step of the choice parameters, every combination of Mode, Interpolation,
+ Scheduling and ReverbOn, and --combinations random settings of all of them - all of it once as
+ an offline render and once in realtime, where the grain budget adapts. Each setting plays a
+ script with notes starting and stopping mid-block, more notes than voices, and block sizes from
+ 1 sample to four times the prepared one, and swaps in a new sample halfway through while notes
+ are sounding. Parameters are changed and samples loaded between blocks with the counter disarmed.
+ --break stops in the debugger on the first allocation so the call stack shows where it came from.
+
+ @return process exit code - 1 if any block allocated or freed memory
+ */
+int runAllocationCheck (const juce::ArgumentList& args);
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 16 Oct 2026 4:47:31pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    struct BenchCase
+    {
+        juce::String name;
+        float density = 50.0f;
+        float length = 500.0f;
+        float activity = 3.0f;
+        int voices = 1;
+        float mode = 1.0f;      // 0 = Delay, 1 = Sample
+        float envelope = 1.0f;  // Triangle, Hann, Exponential, Trapezoid, Custom
+        float interpolation = 2.0f; // Nearest, Linear, Cubic, Sinc
+        int blockSize = 512;
+        bool parallel = false;
+        float grainLimit = 6000.0f; // the highest, so only the limited cases are thinned out
+    };
+
+    struct BenchResult
+    {
+        double nsPerSample = 0.0;
+        double nsPerGrain = 0.0;
+        double worstBlockUs = 0.0;
+        double meanGrains = 0.0;
+    };
+
+    /**
+     base patch plus one axis swept at a time, and the dense corners where the CPU goes
+     */
+    juce::Array<BenchCase> makeCases()
+    {
+        juce::Array<BenchCase> cases;
+        cases.add ({ "base" });
+
+        for (float v : { 2.0f, 10.0f, 200.0f })    { BenchCase c; c.name = "density=" + juce::String (v); c.density = v; cases.add (c); }
+        for (float v : { 20.0f, 1000.0f, 2000.0f }) { BenchCase c; c.name = "length=" + juce::String (v); c.length = v; cases.add (c); }
+        for (float v : { 1.0f, 10.0f })             { BenchCase c; c.name = "activity=" + juce::String (v); c.activity = v; cases.add (c); }
+        for (int v : { 2, 3 })                      { BenchCase c; c.name = "voices=" + juce::String (v); c.voices = v; cases.add (c); }
+        { BenchCase c; c.name = "mode=delay"; c.mode = 0.0f; cases.add (c); }
+        for (float v : { 0.0f, 2.0f, 3.0f, 4.0f })  { BenchCase c; c.name = "envelope=" + juce::String ((int) v); c.envelope = v; cases.add (c); }
+        for (float v : { 0.0f, 1.0f, 3.0f })        { BenchCase c; c.name = "interp=" + juce::String ((int) v); c.interpolation = v; cases.add (c); }
+        for (int v : { 32, 64, 256, 2048 })         { BenchCase c; c.name = "block=" + juce::String (v); c.blockSize = v; cases.add (c); }
+
+        for (float mode : { 0.0f, 1.0f })
+        {
+            for (bool parallel : { false, true })
+            {
+                BenchCase c;
+                c.name = juce::String (mode == 0.0f ? "dense-delay" : "dense-sample") + (parallel ? "-parallel" : "");
+                c.density = 2.0f;
+                c.length = 2000.0f;
+                c.voices = 3;
+                c.mode = mode;
+                c.parallel = parallel;
+                cases.add (c);
+            }
+        }
+
+        // the same dense patch held to the default grain budget
+        for (float mode : { 0.0f, 1.0f })
+        {
+            BenchCase c;
+            c.name = juce::String (mode == 0.0f ? "dense-delay" : "dense-sample") + "-limited";
+            c.density = 2.0f;
+            c.length = 2000.0f;
+            c.voices = 3;
+            c.mode = mode;
+            c.grainLimit = 1024.0f;
+            cases.add (c);
+        }
+
+        return cases;
+    }
+
+    void setParameter (juce::AudioProcessor& processor, const juce::String& paramID, float value)
+    {
+        for (auto* param : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (param))
+                if (ranged->paramID == paramID)
+                    ranged->setValueNotifyingHost (ranged->convertTo0to1 (value));
+    }
+
+    BenchResult runCase (const BenchCase& c, double sampleRate, double seconds)
+    {
+        TryGranulatorAudioProcessor processor;
+
+        setParameter (processor, "Density", c.density);
+        setParameter (processor, "Length", c.length);
+        setParameter (processor, "Activity", c.activity);
+        setParameter (processor, "Mode", c.mode);
+        setParameter (processor, "Envelope", c.envelope);
+        setParameter (processor, "Interpolation", c.interpolation);
+        setParameter (processor, "ParallelVoices", c.parallel ? 1.0f : 0.0f);
+        setParameter (processor, "GrainLimit", c.grainLimit);
+
+        processor.setPlayConfigDetails (0, 2, sampleRate, c.blockSize);
+        processor.setNonRealtime (true);
+        processor.prepareToPlay (sampleRate, c.blockSize);
+
+        juce::AudioBuffer<float> buffer (2, c.blockSize);
+        juce::MidiBuffer midi;
+
+        for (int v = 0; v < c.voices; ++v)
+            midi.addEvent (juce::MidiMessage::noteOn (1, 60 + 4 * v, 1.0f), 0);
+
+        // warm up until the cloud reaches its steady density (one grain length) before measuring
+        const int warmupBlocks = (int) std::ceil ((c.length / 1000.0 + 0.1) * sampleRate / c.blockSize);
+        const int measuredBlocks = juce::jmax (1, (int) std::ceil (seconds * sampleRate / c.blockSize));
+
+        for (int b = 0; b < warmupBlocks; ++b)
+        {
+            processor.processBlock (buffer, midi);
+            midi.clear();
+        }
+
+        BenchResult result;
+        double totalSeconds = 0.0, worstSeconds = 0.0, grainSamples = 0.0;
+
+        for (int b = 0; b < measuredBlocks; ++b)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+            const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+            totalSeconds += elapsed;
+            worstSeconds = juce::jmax (worstSeconds, elapsed);
+            grainSamples += double (processor.getNumActiveGrains()) * c.blockSize;
+        }
+
+        processor.releaseResources();
+
+        const double outputSamples = double (measuredBlocks) * c.blockSize;
+        result.nsPerSample = totalSeconds * 1.0e9 / outputSamples;
+        result.nsPerGrain = grainSamples > 0.0 ? totalSeconds * 1.0e9 / grainSamples : 0.0;
+        result.worstBlockUs = worstSeconds * 1.0e6;
+        result.meanGrains = grainSamples / outputSamples;
+        return result;
+    }
+}
+
+//==============================================================================
+int runBenchmarks (const juce::ArgumentList& args)
+{
+    const double sampleRate = 48000.0;
+    const double seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue() : 2.0;
+    const double tolerance = args.containsOption ("--tolerance") ? args.getValueForOption ("--tolerance").getDoubleValue() : 10.0;
+
+    juce::var baseline;
+    if (args.containsOption ("--baseline"))
+        baseline = juce::JSON::parse (args.getExistingFileForOption ("--baseline"));
+
+    juce::Array<juce::var> results;
+    int regressions = 0;
+
+    std::cout << juce::String ("case").paddedRight (' ', 16) << "ns/sample   ns/grain   worst block us   grains" << std::endl;
+
+    for (auto& c : makeCases())
+    {
+        auto r = runCase (c, sampleRate, seconds);
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("name", c.name);
+        entry->setProperty ("density", c.density);
+        entry->setProperty ("length", c.length);
+        entry->setProperty ("activity", c.activity);
+        entry->setProperty ("voices", c.voices);
+        entry->setProperty ("parallel", c.parallel);
+        entry->setProperty ("mode", c.mode);
+        entry->setProperty ("envelope", c.envelope);
+        entry->setProperty ("interpolation", c.interpolation);
+        entry->setProperty ("blockSize", c.blockSize);
+        entry->setProperty ("nsPerSample", r.nsPerSample);
+        entry->setProperty ("nsPerGrain", r.nsPerGrain);
+        entry->setProperty ("worstBlockUs", r.worstBlockUs);
+        entry->setProperty ("meanGrains", r.meanGrains);
+        results.add (juce::var (entry));
+
+        juce::String line = c.name.paddedRight (' ', 16)
+                          + juce::String (r.nsPerSample, 1).paddedRight (' ', 12)
+                          + juce::String (r.nsPerGrain, 2).paddedRight (' ', 11)
+                          + juce::String (r.worstBlockUs, 1).paddedRight (' ', 17)
+                          + juce::String (r.meanGrains, 1);
+
+        // compare against the same case of an earlier run
+        if (auto* previousCases = baseline["cases"].getArray())
+        {
+            for (auto& previous : *previousCases)
+            {
+                if (previous["name"].toString() != c.name)
+                    continue;
+
+                double before = previous["nsPerSample"];
+                double change = before > 0.0 ? 100.0 * (r.nsPerSample - before) / before : 0.0;
+                line << "   " << (change >= 0.0 ? "+" : "") << juce::String (change, 1) << "%";
+
+                if (change > tolerance)
+                {
+                    line << "  REGRESSION";
+                    ++regressions;
+                }
+            }
+        }
+
+        std::cout << line << std::endl;
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("seconds", seconds);
+    root->setProperty ("cases", results);
+
+    auto json = juce::JSON::toString (juce::var (root));
+    if (args.containsOption ("--json"))
+        args.getFileForOption ("--json").replaceWithText (json);
+
+    if (regressions > 0)
+    {
+        std::cout << regressions << " case(s) slower than the baseline by more than " << tolerance << "%" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 16 Oct 2026 4:47:31pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/**
+ Runs the grain engine benchmark matrix and writes the results as JSON.
+
+    OfflineRender --bench [--seconds 2] [--json results.json] [--baseline previous.json] [--tolerance 10]
+
+ Each case sweeps one of Density, Length, Activity, voice count, Mode, Envelope, Interpolation or block size
+ away from a base patch, plus the dense worst-case corners, rendering the embedded sample.
+ Per case it reports ns per output sample, ns per active grain per sample and the worst block.
+ With --baseline the run is compared against an earlier JSON file and the process fails if any
+ case got slower than the tolerance (in percent). OfflineRender/bench.sh records a baseline per
+ machine and compares later runs against it: ./bench.sh record, then ./bench.sh compare.
+
+ @return process exit code
+ */
+int runBenchmarks (const juce::ArgumentList& args);
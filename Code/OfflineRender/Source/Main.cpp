@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 16 Oct 2026 3:18:06pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ Headless offline renderer for TryGranulatorAudioProcessor.
+
+ Runs the plugin without an editor or audio device, as fast as the CPU allows:
+
+    OfflineRender --source in.wav --notes notes.txt --out out.wav
+                  [--state preset.xml] [--rate 48000] [--block 512] [--tail 3] [--telemetry blocks.csv]
+
+ --state   plugin state, either the XML written by getStateInformation or the raw binary blob
+ --notes   a .mid file, or a text file with one note per line: start(s) length(s) note [velocity 0-1]
+ --tail    seconds rendered after the last note off
+ --telemetry  writes the engine telemetry of every block to a CSV file, see EngineTelemetry.h
+
+ OfflineRender --bench runs the grain engine benchmark matrix instead, see Benchmark.h.
+ OfflineRender --alloc-check checks that the audio thread never allocates, see AllocationCheck.h.
+ OfflineRender --reclaim-check checks that replaced samples are freed, see ReclaimCheck.h.
+
+ OfflineRender.jucer is a Projucer project like the plugin's. Its Builds and JuceLibraryCode folders
+ are generated, not kept in the tree, so write them out before the first build and after changing
+ the .jucer. The modules come from Projucer's global JUCE path:
+
+    Projucer --resave OfflineRender/OfflineRender.jucer
+    make -C OfflineRender/Builds/LinuxMakefile CONFIG=Release
+ */
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "Benchmark.h"
+#include "AllocationCheck.h"
+#include "ReclaimCheck.h"
+
+//==============================================================================
+namespace
+{
+    void fail (const juce::String& message)
+    {
+        std::cerr << "OfflineRender: " << message << std::endl;
+        std::exit (1);
+    }
+
+    /**
+     loads the plugin state from an XML file or a getStateInformation blob
+     */
+    void loadState (juce::AudioProcessor& processor, const juce::File& file)
+    {
+        juce::MemoryBlock data;
+        if (! file.loadFileAsData (data))
+            fail ("can't read state " + file.getFullPathName());
+
+        if (data.getSize() > 0 && static_cast<const char*> (data.getData())[0] == '<')
+        {
+            auto xml = juce::parseXML (data.toString());
+            if (xml == nullptr)
+                fail ("state is not valid XML");
+
+            data.reset();
+            juce::AudioProcessor::copyXmlToBinary (*xml, data);
+        }
+
+        processor.setStateInformation (data.getData(), (int) data.getSize());
+    }
+
+    /**
+     reads the note list into a sequence of note on/off events with timestamps in seconds
+     */
+    juce::MidiMessageSequence loadNotes (const juce::File& file)
+    {
+        juce::MidiMessageSequence notes;
+
+        if (file.hasFileExtension ("mid;midi"))
+        {
+            juce::FileInputStream stream (file);
+            juce::MidiFile midiFile;
+            if (! stream.openedOk() || ! midiFile.readFrom (stream))
+                fail ("can't read MIDI file " + file.getFullPathName());
+
+            midiFile.convertTimestampTicksToSeconds();
+            for (int t = 0; t < midiFile.getNumTracks(); ++t)
+                notes.addSequence (*midiFile.getTrack (t), 0.0);
+        }
+        else
+        {
+            juce::StringArray lines;
+            file.readLines (lines);
+
+            for (auto line : lines)
+            {
+                line = line.upToFirstOccurrenceOf ("#", false, false).trim();
+                if (line.isEmpty())
+                    continue;
+
+                auto tokens = juce::StringArray::fromTokens (line, " \t", "");
+                if (tokens.size() < 3)
+                    fail ("bad note line: " + line);
+
+                double start = tokens[0].getDoubleValue();
+                double length = tokens[1].getDoubleValue();
+                int note = tokens[2].getIntValue();
+                float velocity = tokens.size() > 3 ? (float) tokens[3].getDoubleValue() : 1.0f;
+
+                notes.addEvent (juce::MidiMessage::noteOn (1, note, velocity), start);
+                notes.addEvent (juce::MidiMessage::noteOff (1, note), start + length);
+            }
+        }
+
+        notes.sort();
+        return notes;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    if (args.containsOption ("--bench"))
+        return runBenchmarks (args);
+
+    if (args.containsOption ("--alloc-check"))
+        return runAllocationCheck (args);
+
+    if (args.containsOption ("--reclaim-check"))
+        return runReclaimCheck (args);
+
+    if (! args.containsOption ("--source") || ! args.containsOption ("--notes") || ! args.containsOption ("--out"))
+        fail ("usage: OfflineRender --source in.wav --notes notes.txt --out out.wav [--state preset.xml] [--rate 48000] [--block 512] [--tail 3] [--telemetry blocks.csv]");
+
+    const double sampleRate = args.containsOption ("--rate") ? args.getValueForOption ("--rate").getDoubleValue() : 48000.0;
+    const int blockSize = args.containsOption ("--block") ? args.getValueForOption ("--block").getIntValue() : 512;
+    const double tailSeconds = args.containsOption ("--tail") ? args.getValueForOption ("--tail").getDoubleValue() : 3.0;
+    const int numChannels = 2;
+
+    // ================================================ processor setup ====================================================
+
+    TryGranulatorAudioProcessor processor;
+
+    auto sourceFile = args.getExistingFileForOption ("--source");
+    processor.loadSample (sourceFile.getFullPathName());
+    processor.waitForSampleLoad();
+
+    if (processor.didSampleLoadFail())
+        fail ("can't read " + sourceFile.getFullPathName());
+
+    if (args.containsOption ("--state"))
+        loadState (processor, args.getExistingFileForOption ("--state"));
+
+    auto notes = loadNotes (args.getExistingFileForOption ("--notes"));
+    const double endTime = notes.getEndTime() + tailSeconds;
+    const auto totalSamples = (juce::int64) std::ceil (endTime * sampleRate);
+
+    processor.setPlayConfigDetails (0, numChannels, sampleRate, blockSize);
+    processor.setNonRealtime (true);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    // ================================================ output file ========================================================
+
+    auto outFile = args.getFileForOption ("--out");
+    outFile.deleteFile();
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (new juce::FileOutputStream (outFile), sampleRate,
+                                                                           (unsigned int) numChannels, 24, {}, 0));
+    if (writer == nullptr)
+        fail ("can't write " + outFile.getFullPathName());
+
+    // there's no message loop here, so the telemetry is drained after every block instead of on its timer
+    auto& telemetryMonitor = processor.getTelemetryMonitor();
+    if (args.containsOption ("--telemetry") && ! telemetryMonitor.startCsv (args.getFileForOption ("--telemetry")))
+        fail ("can't write " + args.getFileForOption ("--telemetry").getFullPathName());
+
+    // ================================================ render =============================================================
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+    double peakBlockSeconds = 0.0;
+
+    const auto renderStart = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+    {
+        const int numSamples = (int) juce::jmin ((juce::int64) blockSize, totalSamples - position);
+        const double blockEnd = double (position + numSamples) / sampleRate;
+
+        midi.clear();
+        while (nextEvent < notes.getNumEvents() && notes.getEventTime (nextEvent) < blockEnd)
+        {
+            const auto& message = notes.getEventPointer (nextEvent++)->message;
+            if (message.isNoteOnOrOff())
+            {
+                auto offset = juce::jlimit (0, numSamples - 1, (int) std::round (message.getTimeStamp() * sampleRate) - (int) position);
+                midi.addEvent (message, offset);
+            }
+        }
+
+        buffer.setSize (numChannels, numSamples, false, false, true);
+
+        const auto blockStart = juce::Time::getHighResolutionTicks();
+        processor.processBlock (buffer, midi);
+        const auto blockSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - blockStart);
+        peakBlockSeconds = juce::jmax (peakBlockSeconds, blockSeconds);
+
+        writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        telemetryMonitor.poll();
+    }
+
+    const double renderSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - renderStart);
+    processor.releaseResources();
+    writer.reset();
+    telemetryMonitor.stopCsv();
+
+    // ================================================ report =============================================================
+
+    const double audioSeconds = double (totalSamples) / sampleRate;
+    const double blockBudget = blockSize / sampleRate;
+
+    std::cout << "rendered " << audioSeconds << " s of audio in " << renderSeconds << " s" << std::endl
+              << "realtime factor: " << audioSeconds / juce::jmax (renderSeconds, 1.0e-9) << "x" << std::endl
+              << "peak block: " << peakBlockSeconds * 1000.0 << " ms (" << 100.0 * peakBlockSeconds / blockBudget
+              << "% of the " << blockBudget * 1000.0 << " ms budget)" << std::endl;
+
+    return 0;
+}
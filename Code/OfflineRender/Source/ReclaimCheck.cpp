@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    ReclaimCheck.cpp
+    Created: 24 Oct 2026 11:05:42am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+#include "ReclaimCheck.h"
+#include "../../Source/SampleLoader.h"
+
+namespace
+{
+    /**
+     writes a second of a sine to a file in the given format
+     @return false if the file couldn't be written
+     */
+    bool writeTestFile (juce::AudioFormat& format, const juce::File& file, float frequency)
+    {
+        constexpr double sampleRate = 48000.0;
+        juce::AudioBuffer<float> buffer (2, (int) sampleRate);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * frequency * float (i) / float (sampleRate)));
+
+        file.deleteFile();
+        std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (new juce::FileOutputStream (file), sampleRate,
+                                                                                 (unsigned int) buffer.getNumChannels(), 24, {}, 0));
+        return writer != nullptr && writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    /**
+     stands in for the audio thread of one instance: moves playing on to the latest published source,
+     then tells the loader that is all it plays
+     @return false if nothing new was published
+     */
+    bool acquire (SampleLoader& loader, GrainSampleSource::Ptr& playing)
+    {
+        const bool changed = loader.acquireLatest (playing);
+        loader.setHeld (playing.get(), nullptr, 0);
+        return changed;
+    }
+
+    /**
+     waits for the cache to let go of a source - not a reference to it, holding one would keep it alive by itself
+     @return false if it was still there after timeoutMs
+     */
+    bool waitUntilPurged (const GrainSampleSource* source, int timeoutMs)
+    {
+        auto& cache = GrainSourceCache::getInstance();
+
+        for (int waitedMs = 0; waitedMs < timeoutMs; waitedMs += 10)
+        {
+            if (! cache.contains (source))
+                return true;
+
+            juce::Thread::sleep (10);
+        }
+
+        return ! cache.contains (source);
+    }
+}
+
+//==============================================================================
+int runReclaimCheck (const juce::ArgumentList& args)
+{
+    const int timeoutMs = args.containsOption ("--timeout") ? args.getValueForOption ("--timeout").getIntValue() : 2000;
+
+    juce::TemporaryFile mappedFile (".wav");
+    juce::TemporaryFile decodedFile (".aiff");
+    juce::TemporaryFile otherFile (".wav");
+    juce::WavAudioFormat wav;
+    juce::AiffAudioFormat aiff;
+
+    if (! writeTestFile (wav, mappedFile.getFile(), 220.0f) || ! writeTestFile (aiff, decodedFile.getFile(), 330.0f)
+        || ! writeTestFile (wav, otherFile.getFile(), 440.0f))
+    {
+        std::cout << "can't write the test files" << std::endl;
+        return 1;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    int numFailed = 0;
+
+    {
+        SampleLoader loader (formatManager);
+        GrainSampleSource::Ptr playing;
+
+        for (auto& file : { mappedFile.getFile(), decodedFile.getFile(), mappedFile.getFile() })
+        {
+            loader.loadFile (file);
+            loader.waitUntilIdle();
+
+            const GrainSampleSource* previous = playing.get();
+
+            if (! acquire (loader, playing))
+            {
+                std::cout << file.getFileName() << ": never published" << std::endl;
+                ++numFailed;
+                continue;
+            }
+
+            if (previous == nullptr)
+                continue;
+
+            // previous can't have been reused for the new source - it was still held while that was created
+            const bool released = waitUntilPurged (previous, timeoutMs);
+
+            std::cout << file.getFileName() << ": previous sample " << (released ? "freed" : "still held") << std::endl;
+            if (! released)
+                ++numFailed;
+        }
+
+        playing = nullptr;
+    }
+
+    // two instances: the reference count of a shared source says nothing about either of them
+    {
+        SampleLoader first (formatManager), second (formatManager);
+        GrainSampleSource::Ptr firstPlaying, secondPlaying;
+
+        first.loadFile (mappedFile.getFile());
+        second.loadFile (mappedFile.getFile());
+        first.waitUntilIdle();
+        second.waitUntilIdle();
+
+        if (! acquire (first, firstPlaying) || ! acquire (second, secondPlaying) || firstPlaying != secondPlaying)
+        {
+            std::cout << "shared " << mappedFile.getFile().getFileName() << ": not the same source in both loaders" << std::endl;
+            ++numFailed;
+        }
+        else
+        {
+            const GrainSampleSource* shared = firstPlaying.get();
+
+            first.loadFile (decodedFile.getFile());
+            second.loadFile (otherFile.getFile());
+            first.waitUntilIdle();
+            second.waitUntilIdle();
+            acquire (first, firstPlaying);
+            acquire (second, secondPlaying);
+
+            const bool released = waitUntilPurged (shared, timeoutMs);
+
+            std::cout << "shared " << mappedFile.getFile().getFileName() << ": " << (released ? "freed" : "still held") << std::endl;
+            if (! released)
+                ++numFailed;
+        }
+
+        firstPlaying = nullptr;
+        secondPlaying = nullptr;
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    ReclaimCheck.h
+    Created: 24 Oct 2026 11:05:42am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/**
+ Checks that a sample which has been replaced is freed, not kept around until the plugin goes away.
+
+    OfflineRender --reclaim-check [--timeout 2000]
+
+ Writes two short files to the temp folder, a WAV (memory-mapped) and an AIFF (decoded into
+ memory), and loads WAV, AIFF, WAV through a SampleLoader, moving a stand-in for the audio thread
+ on to each one as it is published. After every switch the previous source must leave the
+ GrainSourceCache within the timeout (in ms); the cache only lets go of a source once nothing else
+ holds it, so that is when its memory is freed or its file unmapped.
+ Then two loaders, standing in for two plugin instances, both load the WAV - the cache hands them
+ the same source - and each moves on to a file of its own; the shared source must leave the cache too.
+
+ @return process exit code - 1 if any replaced sample was still held
+ */
+int runReclaimCheck (const juce::ArgumentList& args);
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Records and compares grain engine benchmark baselines - see Source/Benchmark.h for the cases.
+#
+#   ./bench.sh record [name]     runs the matrix and keeps the results as Baselines/<name>.json
+#   ./bench.sh compare [name]    runs it again and fails if any case got slower than Baselines/<name>.json
+#
+# Timings only mean something on the machine that recorded them, so name defaults to the host name
+# and every machine keeps its own baseline. Record one on the commit you start from, compare after
+# each change, and re-record once a change that moves the numbers on purpose is in.
+#
+#   OFFLINE_RENDER  the OfflineRender binary (default: the Linux Makefile's Release build)
+#   BENCH_SECONDS   seconds rendered per case (default 2)
+#   TOLERANCE       slowdown per case allowed by compare, in percent (default 10)
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+binary=${OFFLINE_RENDER:-$here/Builds/LinuxMakefile/build/OfflineRender}
+seconds=${BENCH_SECONDS:-2}
+tolerance=${TOLERANCE:-10}
+name=${2:-$(hostname -s)}
+baseline=$here/Baselines/$name.json
+
+if [ ! -x "$binary" ]; then
+    echo "bench.sh: no OfflineRender at $binary - build it first (see Source/Main.cpp) or set OFFLINE_RENDER" >&2
+    exit 2
+fi
+
+case "$1" in
+    record)
+        mkdir -p "$here/Baselines"
+        "$binary" --bench --seconds "$seconds" --json "$baseline"
+        echo "baseline written to $baseline"
+        ;;
+    compare)
+        if [ ! -f "$baseline" ]; then
+            echo "bench.sh: no baseline at $baseline - run ./bench.sh record $name first" >&2
+            exit 2
+        fi
+        "$binary" --bench --seconds "$seconds" --baseline "$baseline" --tolerance "$tolerance"
+        ;;
+    *)
+        echo "usage: bench.sh record|compare [name]" >&2
+        exit 2
+        ;;
+esac
@@ -10,127 +10,126 @@
 
 /**
  @class DelayLine - a basic feedback delay
+
+ The buffer is a ring whose length is a power of two, so every index wraps with a single mask
+ instead of a modulo, and indices are free to run past the end (or below zero) - only the mask
+ decides where they land. The delay itself (getDelaySize) can be any length up to that ring.
+
+ Channels are interleaved: the ring holds frames, one sample per channel side by side, so a
+ stereo read pulls left and right from the same cache line. Indices and sizes count frames.
+ The voice writes it a run of frames at a time with process(); a frame's feedback comes from a
+ whole delay back, so no frame of a run shorter than the delay depends on another one of the same run.
+ Delay-mode grains read it through gather(), once per grain per sample, which makes it the
+ innermost loop of the plugin.
  */
 
 #pragma once
+#include <JuceHeader.h>
+
 class DelayLine
 {
 public:
     /**
-     setting the size of the delay buffer
-     @param size integer value of the size (number of samples)
+     setting the size of the delay and allocating the ring that holds it - clears the buffer
+     @param size integer value of the size (number of frames)
+     @param channels int - samples per frame
      */
-    void setMaxSize (int size)
+    void setMaxSize (int size, int channels = 1)
     {
-        delayBuffer.resize (size);
-        maxDelaySize = size;
+        delaySize = juce::jmax (1, size);
+        numChannels = juce::jmax (1, channels);
+        const int ringFrames = juce::nextPowerOfTwo (delaySize);
+        delayBuffer.assign ((size_t) (ringFrames * numChannels), 0.0f);
+        mask = ringFrames - 1;
+        writeHeadPosition = 0;
     }
-    
-    /**
-     sets the incoming sample to the writeHeadPosition
-     @param sample float value of the sample at a certain position
-     */
-    void setInputSample (float sample)
-    {
-        delayBuffer[writeHeadPosition] = sample;
-    }
-    
+
     /**
-     returns the output sample from the readHeadPosition in the delay buffer
-     @return float sample value at the readHeadPosition in the buffer
+     writes a run of frames along with the feedback from the delayed frames, and moves the write head on
+     @param input const float* const* - one pointer per channel, numFrames samples each
+     @param feedback const float* - feedback gain of each frame, 0 to 1
+     @param numFrames int - at most getDelaySize(), so every delayed frame was written before the run
      */
-    float outputSample()
+    void process (const float* const* input, const float* feedback, int numFrames)
     {
-        return delayBuffer[readHeadPosition];
+        jassert (numFrames <= delaySize);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const float* delayed = frame ((writeHeadPosition - delaySize) & mask);
+            float* dest = frame (writeHeadPosition);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                dest[ch] = input[ch][i] + delayed[ch] * feedback[i];
+
+            writeHeadPosition = (writeHeadPosition + 1) & mask;
+        }
     }
-        
+
     /**
-     sets the delaytime in samples and wraps around to make sure readHeadPostion and writeHeadPostition don't get out of bounds
-     @param delayTime_ setting the delaytime - gap between readHead and writeHead Postion in buffer
+     copies numTaps consecutive left and right samples, from frame first on, to dest[0], dest[stride], ... -
+     the taps an interpolator needs around one read position. The grain kernel calls it for every
+     lane of a register of samples and interpolates all the lanes at once. A mono line fills both with
+     the same samples.
+     @param first juce::int64 - any frame index, it is wrapped here
+     @param destL float*
+     @param destR float*
+     @param stride int
      */
-    void setDelayTime (float delayTime_)
+    template <int numTaps>
+    void gather (juce::int64 first, float* destL, float* destR, int stride) const
     {
-        delayTimeSamples = delayTime_;
-        
-        if (writeHeadPosition > delayTime_)
-            readHeadPosition = writeHeadPosition - delayTime_;
+        const int start = int (first & mask);
+        const int right = numChannels > 1 ? 1 : 0;
+        const float* samples = delayBuffer.data();
+
+        if (start + numTaps <= mask + 1)
+        {
+            const float* f = samples + start * numChannels;
+
+            for (int k = 0; k < numTaps; ++k, f += numChannels)
+            {
+                destL[k * stride] = f[0];
+                destR[k * stride] = f[right];
+            }
+        }
         else
-            readHeadPosition = maxDelaySize - (delayTime_ - writeHeadPosition);
-    }
-    
-    /**
-     outputs the delayed sample along with the feedback from the current input sample
-     @param inputSample float input incoming sample to be processed
-     @return outputSample - delayed sample and the feedback of the current sample
-     */
-    float process (float inputSample)
-    {
-        float outputSample = linearInterpolation();
-        delayBuffer[writeHeadPosition] = inputSample + (outputSample * feedbackAmt);
-        writeHeadPosition = (writeHeadPosition + 1) % maxDelaySize;
-        readHeadPosition = fmod((readHeadPosition + 1), maxDelaySize);
-        return outputSample;
+        {
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const float* f = samples + ((start + k) & mask) * numChannels;
+                destL[k * stride] = f[0];
+                destR[k * stride] = f[right];
+            }
+        }
     }
-    
-    /**
-     sets the feedback amount to the feedbackAmt private variable
-     @param feedback_ feedback gain to be set
-     */
-    void setFeedback (float feedback_)
-    {
-        if (feedback_ > 0 && feedback_ <= 1)
-            feedbackAmt = feedback_;
-    }
-    
-    /**
-     liner interpolation between samples
-     */
-    float linearInterpolation ()
-    {
-        int lowerBound = floor(readHeadPosition);
-        int higherBound = lowerBound + 1.0f;
-        
-        float lowerVal = delayBuffer[lowerBound];
-        float higherVal = delayBuffer[higherBound];
-        
-        float frac = readHeadPosition - lowerBound;
-        
-        float output = (1 - frac) * lowerVal + frac * higherVal;
-        
-        return output;
-    }
-    
+
     /**
-     Returns the current write head position in the buffer
+     Returns the frame index a given number of frames behind the write head
+     @param delayFrames int
      */
-    int getWriteHeadPosition()
+    int getIndexBehindWriteHead (int delayFrames) const
     {
-        return writeHeadPosition;
+        return (writeHeadPosition - delayFrames) & mask;
     }
-    
+
     /**
-     Returns the size of the delay buffer in samples
+     Returns the length of the delay in frames
      */
-    int getDelaySize ()
+    int getDelaySize () const
     {
-        return maxDelaySize;
+        return delaySize;
     }
-    
-    /**
-     Reads a sample at a specific index in the delay buffer
-     */
-    float getSampleAtIndex(int index) const
+
+private:
+    float* frame (int index)
     {
-        index = index % maxDelaySize;
-        return delayBuffer[index];
+        return delayBuffer.data() + index * numChannels;
     }
-    
-private:
-    std::vector<float> delayBuffer; // Circular buffer for storing samples
-    int maxDelaySize; // set the size of the delay buffer (currently set to 3 secs)
-    float readHeadPosition = 0.0f; // Current read position in the buffer
-    int writeHeadPosition = 0; // Current write position in the buffer
-    float delayTimeSamples = 0.0f; // set delayTime in samples
-    float feedbackAmt = 0.0; // Amount of feedback apploed in process()
-};
 
+    std::vector<float> delayBuffer; // Circular buffer of interleaved frames, a power of two frames long
+    int numChannels = 1;
+    int mask = 0; // ring size in frames - 1
+    int delaySize = 1; // set the length of the delay (currently set to 3 secs)
+    int writeHeadPosition = 0; // Current write frame in the buffer
+};
@@ -0,0 +1,356 @@
+/*
+  ==============================================================================
+
+    EngineTelemetry.h
+    Created: 21 Oct 2026 9:42:17am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class EngineTelemetry - what the audio engine did, block by block
+
+ The audio thread pushes one Block record per processBlock into a single-producer single-consumer
+ ring (juce::AbstractFifo over a fixed array), plus a few atomic counters that any thread can read.
+ Pushing never blocks and never allocates: when the ring is full because nobody is reading, the
+ record is dropped and counted in getNumLostRecords().
+
+ @class TelemetryMonitor - the reading side, on the message thread
+
+ Drains the ring on a timer, keeps a Summary of the last window (load, spawns, culls and drops per
+ second, voices and grains per voice) and optionally appends every record to a CSV file, one line
+ per block - the standalone app does this when TRYGRANULATOR_TELEMETRY is set to a file path.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+class EngineTelemetry
+{
+public:
+    static constexpr int maxVoices = 8;     // voices past this aren't broken down per voice
+    static constexpr int capacity = 1024;   // blocks - several seconds at any usual block size
+
+    /**
+     one processBlock, as seen by the audio thread
+     */
+    struct Block
+    {
+        juce::int64 sampleTime = 0;     // first sample of the block, counted from prepare()
+        float renderSeconds = 0.0f;     // wall time spent in processBlock
+        float audioSeconds = 0.0f;      // time the block lasts
+        int numVoices = 0;              // voices broken down in grainsPerVoice
+        int activeVoices = 0;
+        std::array<uint16_t, maxVoices> grainsPerVoice {};
+        uint32_t spawned = 0;           // grains started during the block
+        uint32_t culled = 0;            // grains faded out early by the grain budget
+        uint32_t dropped = 0;           // grains lost because a voice's pool was full
+    };
+
+    EngineTelemetry() = default;
+
+    /**
+     restarts the sample clock - call from prepareToPlay, while the audio thread is stopped
+     @param sampleRate double
+     */
+    void prepare (double sampleRate)
+    {
+        currentSampleRate = sampleRate;
+        sampleTime = 0;
+    }
+
+    /**
+     records a block - audio thread only, wait-free
+     @param block Block& - render time, voices and grains; sampleTime, audioSeconds and the grain counts are filled in here
+     @param totalSpawned uint32_t - running count of spawned grains over all voices
+     @param totalCulled uint32_t - running count of culled grains
+     @param totalDropped uint32_t - running count of dropped grains
+     @param numSamples int
+     */
+    void pushBlock (Block& block, uint32_t totalSpawned, uint32_t totalCulled, uint32_t totalDropped, int numSamples)
+    {
+        // the voices' counters only ever go up, so the block's share is the difference (wrapping is fine for uint32_t)
+        block.sampleTime = sampleTime;
+        block.audioSeconds = float (numSamples / currentSampleRate);
+        block.spawned = totalSpawned - lastSpawned;
+        block.culled = totalCulled - lastCulled;
+        block.dropped = totalDropped - lastDropped;
+
+        sampleTime += numSamples;
+        lastSpawned = totalSpawned;
+        lastCulled = totalCulled;
+        lastDropped = totalDropped;
+
+        numBlocks.fetch_add (1, std::memory_order_relaxed);
+        lastRenderSeconds.store (block.renderSeconds, std::memory_order_relaxed);
+        activeVoices.store (block.activeVoices, std::memory_order_relaxed);
+
+        // the reader may reset the peak at any time, so raise it with a compare-exchange rather than a plain store
+        auto peak = peakRenderSeconds.load (std::memory_order_relaxed);
+        while (block.renderSeconds > peak
+               && ! peakRenderSeconds.compare_exchange_weak (peak, block.renderSeconds, std::memory_order_relaxed))
+        {}
+
+        const auto scope = fifo.write (1);
+        if (scope.blockSize1 > 0)
+            records[(size_t) scope.startIndex1] = block;
+        else
+            numLostRecords.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    /**
+     takes the oldest records out of the ring - one reader only, normally TelemetryMonitor
+     @param dest Block* - room for maxRecords
+     @param maxRecords int
+     @return the number of records copied
+     */
+    int pop (Block* dest, int maxRecords)
+    {
+        const auto scope = fifo.read (maxRecords);
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            dest[i] = records[(size_t) (scope.startIndex1 + i)];
+        for (int i = 0; i < scope.blockSize2; ++i)
+            dest[scope.blockSize1 + i] = records[(size_t) (scope.startIndex2 + i)];
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    /**
+     Returns the longest render time since the last resetPeak(), in seconds. Safe from any thread.
+     */
+    float getPeakRenderSeconds() const
+    {
+        return peakRenderSeconds.load (std::memory_order_relaxed);
+    }
+
+    /**
+     starts a new peak measurement. Safe from any thread.
+     */
+    void resetPeak()
+    {
+        peakRenderSeconds.store (0.0f, std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the render time of the most recent block, in seconds. Safe from any thread.
+     */
+    float getLastRenderSeconds() const
+    {
+        return lastRenderSeconds.load (std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the number of voices playing in the most recent block. Safe from any thread.
+     */
+    int getActiveVoices() const
+    {
+        return activeVoices.load (std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the number of blocks rendered so far. Safe from any thread.
+     */
+    juce::uint64 getNumBlocks() const
+    {
+        return numBlocks.load (std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the number of records dropped because the ring was full. Safe from any thread.
+     */
+    juce::uint64 getNumLostRecords() const
+    {
+        return numLostRecords.load (std::memory_order_relaxed);
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<Block, (size_t) capacity> records;
+
+    // audio thread only
+    double currentSampleRate = 44100.0;
+    juce::int64 sampleTime = 0;
+    uint32_t lastSpawned = 0;
+    uint32_t lastCulled = 0;
+    uint32_t lastDropped = 0;
+
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<juce::uint64> numLostRecords { 0 };
+    std::atomic<float> lastRenderSeconds { 0.0f };
+    std::atomic<float> peakRenderSeconds { 0.0f };
+    std::atomic<int> activeVoices { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (EngineTelemetry)
+};
+
+//==============================================================================
+class TelemetryMonitor : private juce::Timer
+{
+public:
+    /**
+     the engine over the last poll window
+     */
+    struct Summary
+    {
+        double load = 0.0;              // render time over audio time
+        double peakLoad = 0.0;          // the worst single block in the window
+        double spawnsPerSecond = 0.0;   // per second of audio
+        double cullsPerSecond = 0.0;
+        double dropsPerSecond = 0.0;
+        int activeVoices = 0;
+        int activeGrains = 0;
+        int numVoices = 0;
+        std::array<int, EngineTelemetry::maxVoices> grainsPerVoice {};
+        juce::uint64 lostRecords = 0;
+    };
+
+    explicit TelemetryMonitor (EngineTelemetry& source) : telemetry (source) {}
+
+    ~TelemetryMonitor() override
+    {
+        stopTimer();
+    }
+
+    /**
+     polls the engine on the message thread - does nothing where there is no message loop (the OfflineRender tool calls poll() itself)
+     @param hz int
+     */
+    void start (int hz = 10)
+    {
+        if (juce::MessageManager::getInstanceWithoutCreating() != nullptr)
+            startTimerHz (hz);
+    }
+
+    void stop()
+    {
+        stopTimer();
+    }
+
+    /**
+     drains the ring, updates the summary and writes the CSV - message thread, or whichever single thread reads the telemetry
+     */
+    void poll()
+    {
+        double audioSeconds = 0.0, renderSeconds = 0.0, peakLoad = 0.0;
+        juce::uint64 spawned = 0, culled = 0, dropped = 0;
+        int numRead;
+
+        while ((numRead = telemetry.pop (scratch.data(), (int) scratch.size())) > 0)
+        {
+            for (int i = 0; i < numRead; ++i)
+            {
+                const auto& block = scratch[(size_t) i];
+                audioSeconds += block.audioSeconds;
+                renderSeconds += block.renderSeconds;
+                peakLoad = juce::jmax (peakLoad, double (block.renderSeconds / juce::jmax (block.audioSeconds, 1.0e-9f)));
+                spawned += block.spawned;
+                culled += block.culled;
+                dropped += block.dropped;
+
+                if (csv != nullptr)
+                    writeCsvLine (block);
+            }
+
+            const auto& latest = scratch[(size_t) numRead - 1];
+            summary.activeVoices = latest.activeVoices;
+            summary.numVoices = latest.numVoices;
+            summary.activeGrains = 0;
+            for (int v = 0; v < EngineTelemetry::maxVoices; ++v)
+            {
+                summary.grainsPerVoice[(size_t) v] = latest.grainsPerVoice[(size_t) v];
+                summary.activeGrains += latest.grainsPerVoice[(size_t) v];
+            }
+        }
+
+        // with the transport stopped nothing arrives, keep showing the last window
+        if (audioSeconds > 0.0)
+        {
+            summary.load = renderSeconds / audioSeconds;
+            summary.peakLoad = peakLoad;
+            summary.spawnsPerSecond = double (spawned) / audioSeconds;
+            summary.cullsPerSecond = double (culled) / audioSeconds;
+            summary.dropsPerSecond = double (dropped) / audioSeconds;
+        }
+
+        summary.lostRecords = telemetry.getNumLostRecords();
+
+        if (csv != nullptr)
+            csv->flush();
+    }
+
+    /**
+     Returns the summary of the last poll
+     */
+    const Summary& getSummary() const
+    {
+        return summary;
+    }
+
+    /**
+     starts appending every block to a CSV file, replacing what was there
+     @param file const juce::File&
+     @return false if the file can't be written
+     */
+    bool startCsv (const juce::File& file)
+    {
+        stopCsv();
+        file.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        if (! stream->openedOk())
+            return false;
+
+        csv = std::move (stream);
+        csvHeaderWritten = false;
+        return true;
+    }
+
+    void stopCsv()
+    {
+        csv.reset();
+    }
+
+private:
+    void timerCallback() override
+    {
+        poll();
+    }
+
+    void writeCsvLine (const EngineTelemetry::Block& block)
+    {
+        // the voice columns follow the first block, the voice count is fixed for the processor's lifetime
+        if (! csvHeaderWritten)
+        {
+            *csv << "sample,render_ms,audio_ms,load,active_voices";
+            for (int v = 0; v < block.numVoices; ++v)
+                *csv << ",grains_voice" << v;
+            *csv << ",spawned,culled,dropped\n";
+            csvHeaderWritten = true;
+        }
+
+        *csv << juce::String (block.sampleTime)
+             << "," << juce::String (block.renderSeconds * 1000.0f, 4)
+             << "," << juce::String (block.audioSeconds * 1000.0f, 4)
+             << "," << juce::String (block.renderSeconds / juce::jmax (block.audioSeconds, 1.0e-9f), 4)
+             << "," << juce::String (block.activeVoices);
+
+        for (int v = 0; v < block.numVoices; ++v)
+            *csv << "," << juce::String (block.grainsPerVoice[(size_t) v]);
+
+        *csv << "," << juce::String (block.spawned)
+             << "," << juce::String (block.culled)
+             << "," << juce::String (block.dropped) << "\n";
+    }
+
+    EngineTelemetry& telemetry;
+    std::array<EngineTelemetry::Block, 64> scratch;
+    Summary summary;
+
+    std::unique_ptr<juce::FileOutputStream> csv;
+    bool csvHeaderWritten = false;
+
+    JUCE_DECLARE_NON_COPYABLE (TelemetryMonitor)
+};
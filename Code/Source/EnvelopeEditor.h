@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    EnvelopeEditor.h
+    Created: 23 Oct 2026 10:41:18am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class EnvelopeEditor - draws the shape of the "Custom" grain envelope
+
+ A breakpoint editor over the grain's length (left to right) and gain (bottom to top). Clicking
+ adds a point, dragging moves one, double-clicking removes it. The first and last points stay at
+ the start and end of the grain, and a point can't be dragged past its neighbours, so the points
+ are always sorted. The shape is handed to the processor when the mouse is released, which saves
+ it with the plugin state and swaps it into the envelope tables.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+class EnvelopeEditor : public juce::Component
+{
+public:
+    explicit EnvelopeEditor (TryGranulatorAudioProcessor& p) : audioProcessor (p)
+    {
+        points = audioProcessor.getCustomEnvelope();
+
+        // nothing drawn yet: start from the Hann window the custom slot plays until then
+        if (points.size() < 2)
+        {
+            points.clear();
+            for (int i = 0; i <= 16; ++i)
+            {
+                const float x = float (i) / 16.0f;
+                points.add ({ x, 0.5f * (1.0f - std::cos (juce::MathConstants<float>::twoPi * x)) });
+            }
+        }
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        g.fillAll (juce::Colour (0xff15171c));
+
+        const auto area = getPlotArea();
+        g.setColour (juce::Colour (0xff3b4250));
+        g.drawRect (area);
+
+        g.setColour (juce::Colours::lightgrey);
+        g.setFont (juce::FontOptions (12.0f));
+        g.drawText ("custom envelope", area.reduced (4.0f), juce::Justification::topLeft);
+
+        juce::Path shape;
+        for (int i = 0; i < points.size(); ++i)
+        {
+            const auto p = toScreen (points.getReference (i));
+            if (i == 0)
+                shape.startNewSubPath (p);
+            else
+                shape.lineTo (p);
+        }
+
+        g.setColour (juce::Colour (0xff4fc3f7));
+        g.strokePath (shape, juce::PathStrokeType (2.0f));
+
+        for (int i = 0; i < points.size(); ++i)
+        {
+            const auto p = toScreen (points.getReference (i));
+            g.setColour (i == dragged ? juce::Colours::white : juce::Colour (0xff4fc3f7));
+            g.fillEllipse (p.x - pointRadius, p.y - pointRadius, pointRadius * 2.0f, pointRadius * 2.0f);
+        }
+    }
+
+    void mouseDown (const juce::MouseEvent& e) override
+    {
+        dragged = findPoint (e.position);
+
+        if (dragged < 0)
+        {
+            const auto p = fromScreen (e.position);
+
+            // a new point goes between the two it lands between
+            int index = 1;
+            while (index < points.size() - 1 && points.getReference (index).x < p.x)
+                ++index;
+
+            points.insert (index, p);
+            dragged = index;
+        }
+
+        movePoint (e.position);
+    }
+
+    void mouseDrag (const juce::MouseEvent& e) override
+    {
+        movePoint (e.position);
+    }
+
+    void mouseUp (const juce::MouseEvent&) override
+    {
+        dragged = -1;
+        audioProcessor.setCustomEnvelope (points);
+        repaint();
+    }
+
+    void mouseDoubleClick (const juce::MouseEvent& e) override
+    {
+        const int index = findPoint (e.position);
+
+        if (index > 0 && index < points.size() - 1)
+        {
+            points.remove (index);
+            audioProcessor.setCustomEnvelope (points);
+            repaint();
+        }
+    }
+
+private:
+    juce::Rectangle<float> getPlotArea() const
+    {
+        return getLocalBounds().toFloat().reduced (6.0f);
+    }
+
+    juce::Point<float> toScreen (juce::Point<float> p) const
+    {
+        const auto area = getPlotArea();
+        return { area.getX() + p.x * area.getWidth(), area.getBottom() - p.y * area.getHeight() };
+    }
+
+    juce::Point<float> fromScreen (juce::Point<float> p) const
+    {
+        const auto area = getPlotArea();
+        return { juce::jlimit (0.0f, 1.0f, (p.x - area.getX()) / juce::jmax (1.0f, area.getWidth())),
+                 juce::jlimit (0.0f, 1.0f, (area.getBottom() - p.y) / juce::jmax (1.0f, area.getHeight())) };
+    }
+
+    /**
+     Returns the index of the point under the mouse, or -1
+     @param position juce::Point<float> - in component coordinates
+     */
+    int findPoint (juce::Point<float> position) const
+    {
+        for (int i = 0; i < points.size(); ++i)
+            if (toScreen (points.getReference (i)).getDistanceFrom (position) <= pointRadius * 2.0f)
+                return i;
+
+        return -1;
+    }
+
+    /**
+     moves the dragged point, the ends only up and down, the rest between their neighbours
+     @param position juce::Point<float> - in component coordinates
+     */
+    void movePoint (juce::Point<float> position)
+    {
+        if (dragged < 0)
+            return;
+
+        auto p = fromScreen (position);
+        const int last = points.size() - 1;
+
+        if (dragged == 0)
+            p.x = 0.0f;
+        else if (dragged == last)
+            p.x = 1.0f;
+        else
+            p.x = juce::jlimit (points.getReference (dragged - 1).x, points.getReference (dragged + 1).x, p.x);
+
+        points.set (dragged, p);
+        repaint();
+    }
+
+    static constexpr float pointRadius = 4.0f;
+
+    TryGranulatorAudioProcessor& audioProcessor;
+    juce::Array<juce::Point<float>> points;
+    int dragged = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeEditor)
+};
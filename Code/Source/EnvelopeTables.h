@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    EnvelopeTables.h
+    Created: 16 Oct 2026 9:12:40am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainEnvelopeTables - precomputed grain envelope shapes shared by every grain
+
+ The tables are filled once in prepareToPlay and are read-only from the audio thread.
+ Grains index them with a 32-bit fixed-point phase: the top bits select the table entry and
+ the remaining bits interpolate linearly towards the next one, so a grain of any length walks
+ the whole table from 0 to 1 without calling std::cos or std::pow.
+
+ The custom shape is triple-buffered. The message thread draws into its own slot and swaps it
+ with the shared middle slot; the audio thread takes the middle slot in acquireCustomShape() at
+ the start of a block and reads only that one until the next block. Neither side ever writes a
+ slot the other is using, however often a shape is drawn.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+class GrainEnvelopeTables
+{
+public:
+    // Matches the order of the "Envelope" choice parameter
+    enum Shape
+    {
+        triangle = 0,
+        hann,
+        exponential,
+        trapezoid,
+        custom,
+        numShapes
+    };
+
+    static constexpr int tableBits = 12;
+    static constexpr int tableSize = 1 << tableBits;
+    static constexpr int fracBits = 32 - tableBits;
+
+    GrainEnvelopeTables()
+    {
+        // Until a shape is drawn the custom slot behaves like a Hann window
+        for (auto& table : customTables)
+            fillTable (table, hannShape);
+    }
+
+    /**
+     fills the fixed shapes - called from prepareToPlay, never from the audio thread
+     */
+    void build()
+    {
+        fillTable (tables[triangle], triangleShape);
+        fillTable (tables[hann], hannShape);
+        fillTable (tables[exponential], exponentialShape);
+        fillTable (tables[trapezoid], trapezoidShape);
+    }
+
+    /**
+     resamples a user-drawn breakpoint envelope into the custom table - message thread, one writer only.
+     The points are linearly interpolated and must be sorted by x; both x and y are in 0 to 1.
+     The new table is written into the writer's own slot and then swapped into the middle, so the
+     audio thread never sees a half-written shape.
+
+     @param points breakpoints of the drawn envelope
+     */
+    void setCustomShape (const juce::Array<juce::Point<float>>& points)
+    {
+        if (points.isEmpty())
+            return;
+
+        auto& table = customTables[(size_t) writeSlot];
+
+        int segment = 0;
+        for (int i = 0; i <= tableSize; ++i)
+        {
+            float x = float (i) / float (tableSize);
+
+            while (segment < points.size() - 1 && points.getReference (segment + 1).x < x)
+                ++segment;
+
+            auto a = points[segment];
+            auto b = points[juce::jmin (segment + 1, points.size() - 1)];
+
+            float y = a.y;
+            if (b.x > a.x)
+                y = a.y + (b.y - a.y) * juce::jlimit (0.0f, 1.0f, (x - a.x) / (b.x - a.x));
+
+            table[(size_t) i] = juce::jlimit (0.0f, 1.0f, y);
+        }
+
+        writeSlot = middleSlot.exchange (writeSlot | freshBit, std::memory_order_acq_rel) & slotMask;
+    }
+
+    /**
+     takes the most recently drawn custom shape, if there is one - audio thread, once at the start of
+     each block and before any voice renders, so every voice reads the same table for the whole block
+     */
+    void acquireCustomShape()
+    {
+        if ((middleSlot.load (std::memory_order_relaxed) & freshBit) == 0)
+            return;
+
+        readSlot.store (middleSlot.exchange (readSlot.load (std::memory_order_relaxed), std::memory_order_acq_rel) & slotMask,
+                        std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the table for a shape - the pointer stays valid for the life of the object
+     @param shape index of the "Envelope" parameter
+     */
+    const float* getTable (int shape) const
+    {
+        if (shape == custom)
+            return customTables[(size_t) readSlot.load (std::memory_order_relaxed)].data();
+
+        return tables[(size_t) juce::jlimit (0, (int) custom - 1, shape)].data();
+    }
+
+    /**
+     fixed-point phase step that covers the whole table in the given number of samples
+     @param lengthInSamples grain length
+     */
+    static uint32_t phaseIncrementFor (int lengthInSamples)
+    {
+        auto increment = (uint64_t (1) << 32) / (uint64_t) juce::jmax (1, lengthInSamples);
+        return (uint32_t) juce::jmin (increment, (uint64_t) 0xffffffffu);
+    }
+
+    /**
+     reads a table at a fixed-point phase with linear interpolation
+     @param table one of the tables returned by getTable()
+     @param phase 32-bit phase, 0 is the start of the grain and 2^32 the end
+     */
+    static float lookup (const float* table, uint32_t phase)
+    {
+        const uint32_t index = phase >> fracBits;
+        const float frac = float (phase & ((1u << fracBits) - 1u)) * (1.0f / float (1u << fracBits));
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+
+private:
+    using Table = std::array<float, tableSize + 1>; // one guard point so lookup never wraps
+
+    template <typename ShapeFunction>
+    static void fillTable (Table& table, ShapeFunction shape)
+    {
+        for (int i = 0; i < tableSize; ++i)
+            table[(size_t) i] = shape (float (i) / float (tableSize));
+
+        table[tableSize] = 0.0f;
+    }
+
+    //==================================================== Envelope Shape Functions =========================================================
+
+    static float triangleShape (float phase)
+    {
+        return phase < 0.5f ? 2.0f * phase : 2.0f * (1.0f - phase);
+    }
+
+    static float hannShape (float phase)
+    {
+        return 0.5f * (1.0f - std::cos (2.0f * juce::MathConstants<float>::pi * phase));
+    }
+
+    static float exponentialShape (float phase)
+    {
+        if (phase < 0.5f)
+            return std::pow (phase * 2.0f, 3.0f); // fade-in
+
+        return std::pow ((1.0f - phase) * 2.0f, 3.0f); // fade-out
+    }
+
+    static float trapezoidShape (float phase)
+    {
+        // attack and release portion (20% each)
+        const float attackPortion = 0.2f;
+        const float releasePortion = 0.2f;
+
+        if (phase < attackPortion)
+            return phase / attackPortion;
+
+        if (phase > 1.0f - releasePortion)
+            return (1.0f - phase) / releasePortion;
+
+        return 1.0f;
+    }
+
+    std::array<Table, custom> tables {};
+    // custom shape slots: the audio thread reads readSlot, the writer draws into writeSlot, middleSlot is handed between them
+    static constexpr int slotMask = 3;
+    static constexpr int freshBit = 4;  // set in middleSlot when it holds a shape the audio thread hasn't taken yet
+
+    std::array<Table, 3> customTables {};
+    std::atomic<int> readSlot { 0 };
+    std::atomic<int> middleSlot { 1 };
+    int writeSlot = 2;
+};
@@ -0,0 +1,310 @@
+/*
+  ==============================================================================
+
+    FdnReverb.h
+    Created: 22 Oct 2026 2:26:51pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class FdnReverb - eight-line feedback delay network, mixed into the block in place
+
+ Every sample, the eight delay lines are read, low-pass damped, scaled so each line loses 60 dB
+ over the decay time, mixed through a Householder matrix (x - 2/N * sum(x)) and written back
+ together with the input. The lines are processed as whole juce::dsp::SIMDRegisters - two
+ registers of four lines with SSE or NEON - so damping, decay, mixing and the output taps are
+ register operations. Only the eight taps are read one by one, since each line has its own length.
+ The Householder matrix needs a single horizontal sum, where a Hadamard one would need lane
+ shuffles that SIMDRegister doesn't offer.
+
+ The lines share one ring buffer with the eight lines of a frame side by side, allocated in
+ prepare() for the longest room at the current sample rate; process() never allocates. Size and
+ mix glide on ControlRamps stepped once per control tick; the line lengths and gains are only
+ recalculated in a tick where the size moved, or after decay or damping changed. While the size
+ moves, each read tap slides sample by sample from its old length to its new one, reading between
+ frames, so the room bends in pitch instead of clicking; at rest the taps sit on whole frames.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "GrainParameters.h"
+
+class FdnReverb
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+    static constexpr int numLines = 8;
+    static constexpr int numGroups = numLines / lanes;
+    static_assert (numLines % lanes == 0, "the lines must fill whole registers");
+
+    /**
+     allocates the delay lines - called from prepareToPlay, never while rendering
+     @param sampleRate double
+     @param size float - room size 0-1 to start from
+     @param mix float - wet level to start from
+     */
+    void prepare (double sampleRate, float size, float mix)
+    {
+        currentSampleRate = sampleRate;
+
+        const int longest = (int) std::ceil (baseLengthsMs.back() * maxSizeScale * 0.001 * sampleRate) + 1;
+        numFrames = juce::nextPowerOfTwo (longest + 1);
+        mask = numFrames - 1;
+
+        // SIMDRegister loads and stores need frames aligned to a whole register, which malloc doesn't promise for AVX
+        linesStorage.allocate ((size_t) (numFrames * numLines + lanes), true);
+        lines = Vec::getNextSIMDAlignedPtr (linesStorage.get());
+
+        sizeRamp.reset (sampleRate, rampSeconds, size);
+        mixRamp.reset (sampleRate, rampSeconds, mix);
+        targetSize = size;
+        targetMix = mix;
+
+        // the taps start out at the lengths for this size rather than sliding there
+        updateLines (size);
+        for (int k = 0; k < numLines; ++k)
+            tapDelay[(size_t) k] = (float) lineLength[(size_t) k];
+
+        reset();
+    }
+
+    /**
+     Returns how long the tail rings on after the input stops: the decay time plus one pass through the longest line
+     @param decaySeconds float - as passed to setParameters
+     */
+    static double getTailSeconds (float decaySeconds)
+    {
+        return (double) decaySeconds + baseLengthsMs.back() * maxSizeScale * 0.001;
+    }
+
+    /**
+     silences the tail - when the reverb is switched back on, so an old tail doesn't come back
+     */
+    void reset()
+    {
+        if (lines != nullptr)
+            std::fill (lines, lines + numFrames * numLines, 0.0f);
+
+        for (auto& state : damped)
+            state = Vec::expand (0.0f);
+
+        writeFrame = 0;
+    }
+
+    /**
+     fades the wet signal in from nothing, together with reset() when the reverb is switched on
+     */
+    void restartMix()
+    {
+        mixRamp.reset (currentSampleRate, rampSeconds, 0.0f);
+    }
+
+    /**
+     takes the block's parameter values - audio thread, once per block
+     @param size float - 0-1, scales every line
+     @param decaySeconds float - time for the tail to fall by 60 dB
+     @param damping float - 0-1, how fast high frequencies die away
+     @param mix float - wet level, 0-1
+     */
+    void setParameters (float size, float decaySeconds, float damping, float mix)
+    {
+        if (decaySeconds != decay || damping != dampingAmount)
+        {
+            decay = decaySeconds;
+            dampingAmount = damping;
+            linesDirty = true;
+        }
+
+        targetSize = size;
+        targetMix = mix;
+    }
+
+    /**
+     adds the reverb to the first two channels of the buffer in place, dry + mix * (wet - dry)
+     @param buffer juce::AudioBuffer<float>&
+     */
+    void process (juce::AudioBuffer<float>& buffer)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        const int numSamples = buffer.getNumSamples();
+        if (lines == nullptr || buffer.getNumChannels() == 0 || numSamples == 0)
+            return;
+
+        float* left = buffer.getWritePointer (0);
+        float* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer (1) : nullptr;
+
+        alignas (Vec::SIMDRegisterSize) float taps[numLines], nextTaps[numLines], tapFrac[numLines];
+        float delayStep[numLines];
+        const auto householderScale = Vec::expand (2.0f / numLines);
+
+        for (int tickStart = 0; tickStart < numSamples; tickStart += controlInterval)
+        {
+            const int tickLength = juce::jmin (controlInterval, numSamples - tickStart);
+            sizeRamp.advance (targetSize, tickLength);
+            mixRamp.advance (targetMix, tickLength);
+
+            const float size = sizeRamp.at (tickLength - 1);
+            if (linesDirty || size != appliedSize)
+                updateLines (size);
+
+            // every tap reaches its new length by the end of the tick
+            bool sliding = false;
+            for (int k = 0; k < numLines; ++k)
+            {
+                delayStep[k] = ((float) lineLength[(size_t) k] - tapDelay[(size_t) k]) / (float) tickLength;
+                sliding = sliding || delayStep[k] != 0.0f;
+            }
+
+            for (int offset = 0; offset < tickLength; ++offset)
+            {
+                const int i = tickStart + offset;
+                const float inL = left[i];
+                const float inR = right != nullptr ? right[i] : inL;
+
+                if (sliding)
+                {
+                    // each tap reads between two frames, delay and delay + 1 back
+                    for (int k = 0; k < numLines; ++k)
+                    {
+                        const float delay = tapDelay[(size_t) k] + delayStep[k] * (float) (offset + 1);
+                        const int whole = (int) delay;
+                        const int frame = (writeFrame - whole) & mask;
+                        tapFrac[k] = delay - (float) whole;
+                        taps[k] = lines[(size_t) (frame * numLines + k)];
+                        nextTaps[k] = lines[(size_t) (((frame - 1) & mask) * numLines + k)];
+                    }
+
+                    for (int g = 0; g < numGroups; ++g)
+                    {
+                        const auto x0 = Vec::fromRawArray (taps + g * lanes);
+                        (x0 + Vec::fromRawArray (tapFrac + g * lanes) * (Vec::fromRawArray (nextTaps + g * lanes) - x0)).copyToRawArray (taps + g * lanes);
+                    }
+                }
+                else
+                {
+                    for (int k = 0; k < numLines; ++k)
+                        taps[k] = lines[(size_t) (((writeFrame - lineLength[(size_t) k]) & mask) * numLines + k)];
+                }
+
+                // damp and decay every line, then take the output taps and the sum the Householder matrix needs
+                Vec decayed[numGroups];
+                auto wetL = Vec::expand (0.0f), wetR = Vec::expand (0.0f), total = Vec::expand (0.0f);
+
+                for (int g = 0; g < numGroups; ++g)
+                {
+                    const auto x = Vec::fromRawArray (taps + g * lanes);
+                    damped[(size_t) g] = x + (damped[(size_t) g] - x) * dampingCoefficient;
+                    decayed[g] = damped[(size_t) g] * lineGain[(size_t) g];
+
+                    wetL += decayed[g] * outputSignsL[(size_t) g];
+                    wetR += decayed[g] * outputSignsR[(size_t) g];
+                    total += decayed[g];
+                }
+
+                // x - 2/N * sum(x) keeps the energy of the lines, and spreads every line into all the others
+                const auto reflection = householderScale * Vec::expand (total.sum());
+                float* written = lines + (size_t) (writeFrame * numLines);
+
+                for (int g = 0; g < numGroups; ++g)
+                {
+                    const auto input = inputSignsL[(size_t) g] * inL + inputSignsR[(size_t) g] * inR;
+                    (decayed[g] - reflection + input).copyToRawArray (written + g * lanes);
+                }
+
+                writeFrame = (writeFrame + 1) & mask;
+
+                const float mix = mixRamp.at (offset);
+                left[i] = inL + mix * (wetL.sum() * outputGain - inL);
+                if (right != nullptr)
+                    right[i] = inR + mix * (wetR.sum() * outputGain - inR);
+            }
+
+            for (int k = 0; k < numLines; ++k)
+                tapDelay[(size_t) k] = (float) lineLength[(size_t) k];
+        }
+    }
+
+private:
+    /**
+     line lengths for a room size, and the per-line gains and damping that go with them
+     @param size float - 0-1
+     */
+    void updateLines (float size)
+    {
+        appliedSize = size;
+        linesDirty = false;
+
+        const double scale = minSizeScale + (maxSizeScale - minSizeScale) * juce::jlimit (0.0f, 1.0f, size);
+        const double decayTime = juce::jmax (0.05, (double) decay);
+        alignas (Vec::SIMDRegisterSize) float gains[numLines];
+
+        for (int k = 0; k < numLines; ++k)
+        {
+            const int length = juce::jlimit (1, mask, (int) std::round (baseLengthsMs[(size_t) k] * scale * 0.001 * currentSampleRate));
+            lineLength[(size_t) k] = length;
+
+            // a line of n samples is passed decayTime * sampleRate / n times while the tail falls 60 dB
+            gains[k] = (float) std::pow (10.0, -3.0 * length / (decayTime * currentSampleRate));
+        }
+
+        for (int g = 0; g < numGroups; ++g)
+            lineGain[(size_t) g] = Vec::fromRawArray (gains + g * lanes);
+
+        // damping 0 leaves the tail bright (20 kHz), 1 dulls it down to 1 kHz
+        const double dampingHz = 20000.0 * std::pow (0.05, (double) juce::jlimit (0.0f, 1.0f, dampingAmount));
+        dampingCoefficient = Vec::expand ((float) std::exp (-juce::MathConstants<double>::twoPi * dampingHz / currentSampleRate));
+    }
+
+    static std::array<Vec, numGroups> makeSigns (std::array<float, numLines> signs)
+    {
+        alignas (Vec::SIMDRegisterSize) float values[numLines];
+        std::copy (signs.begin(), signs.end(), values);
+
+        std::array<Vec, numGroups> registers;
+        for (int g = 0; g < numGroups; ++g)
+            registers[(size_t) g] = Vec::fromRawArray (values + g * lanes);
+
+        return registers;
+    }
+
+    // line lengths at a size scale of 1, mutually prime-ish so the echoes don't pile up on a common period
+    static constexpr std::array<double, numLines> baseLengthsMs { 29.7, 33.9, 37.3, 41.9, 45.7, 51.1, 56.3, 61.7 };
+    static constexpr double minSizeScale = 0.35;
+    static constexpr double maxSizeScale = 2.0;
+    static constexpr double rampSeconds = 0.1;
+    static constexpr int controlInterval = 32; // samples per control tick, as in GrainVoice
+    static constexpr float outputGain = 0.5f;
+
+    // left feeds the even lines and right the odd ones, with alternating signs; the two outputs tap every line with different signs
+    const std::array<Vec, numGroups> inputSignsL = makeSigns ({ 0.5f, 0.0f, -0.5f, 0.0f, 0.5f, 0.0f, -0.5f, 0.0f });
+    const std::array<Vec, numGroups> inputSignsR = makeSigns ({ 0.0f, 0.5f, 0.0f, -0.5f, 0.0f, 0.5f, 0.0f, -0.5f });
+    const std::array<Vec, numGroups> outputSignsL = makeSigns ({ 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f });
+    const std::array<Vec, numGroups> outputSignsR = makeSigns ({ 1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f });
+
+    double currentSampleRate = 44100.0;
+    juce::HeapBlock<float> linesStorage;
+    float* lines = nullptr;         // numFrames frames of numLines samples, line k at index k of each frame, register-aligned in linesStorage
+    int numFrames = 0;
+    int mask = 0;
+    int writeFrame = 0;
+
+    std::array<int, numLines> lineLength {};   // in frames, for the current size
+    std::array<float, numLines> tapDelay {};   // where each read tap was at the end of the last tick
+    std::array<Vec, numGroups> lineGain {};
+    std::array<Vec, numGroups> damped {};  // one-pole low-pass state of every line
+    Vec dampingCoefficient = Vec::expand (0.0f);
+
+    ControlRamp sizeRamp;
+    ControlRamp mixRamp;
+    float targetSize = 0.5f;
+    float targetMix = 0.0f;
+    float appliedSize = -1.0f;
+    float decay = 1.5f;
+    float dampingAmount = 0.5f;
+    bool linesDirty = true;
+};
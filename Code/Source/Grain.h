@@ -10,7 +10,7 @@
 
 #pragma once
 #include <JuceHeader.h>
-#include "DelayLine.h"
+#include "EnvelopeTables.h"
 
 class Grain{
 public:
@@ -20,32 +20,22 @@ public:
     // rate: playback rate (1.0 = normal, >1 = faster, <1 = slower)
     // level: amplitude multiplier (0.0 to 1.0)
     // position: start point in the source buffer (0.0 to 1.0 as a fraction)
+    // pan: stereo position (-1.0 left to 1.0 right)
     Grain(): onset(0), length(0), rate(1.0f), level(1.0f), position(0.0f), sr(48000.0f), delayOffset(0.0f){}
 
-    Grain(int onset, int length, float rate, float level, float position, int delayOffset, float sr, float stereoWidth);
-    
-    void sampleProcess(juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& source, int time, int sampleIndex, int envelope, int activity);
-    
-    void delayProcess(juce::AudioBuffer<float>& output, DelayLine& source, int time, int sampleIndex, int envelope, int activity);
+    Grain(int onset, int length, float rate, float level, float position, int delayOffset, float sr, float pan);
     
     bool isDone (int time) const;
     
-    float getSample(const juce::AudioBuffer<float>& buffer, int channel, int currentIndex);
-    
-    float triEnvelope(int t) const;
-    
-    float hannEnvelope(int t) const;
-    
-    float expEnvelope(int t) const;
-
-    
-    float trapezoidEnvelope(int t) const;
-    
-    int getOnset();
-    int getLength();
-    float getRate();
-    float getDelayOffset();
-    float getSmoothedLevel();
+    int getOnset() const;
+    int getLength() const;
+    float getRate() const;
+    float getPosition() const;
+    float getDelayOffset() const;
+    float getLevel() const;
+    float getLeftGain() const;
+    float getRightGain() const;
+    uint32_t getEnvIncrement() const;
     
 private:
     int onset;
@@ -56,8 +46,9 @@ private:
     float sr;
     int delayOffset;
     float pan = 0.0f;
+    uint32_t envIncrement = 0; // fixed-point envelope phase step per sample
     
-    juce::SmoothedValue<float> smoothLevel;
-    juce::SmoothedValue<float> smoothRate;
-
+    // pan law gains, worked out once when the grain is spawned
+    float leftGain = 0.70710678f;
+    float rightGain = 0.70710678f;
 };
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    GrainBudget.h
+    Created: 20 Oct 2026 10:18:05am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainBudget - how many grains one plugin instance may keep alive
+
+ The hard limit comes from the "GrainLimit" parameter. On top of it the budget watches how long
+ each block takes (the processor times it once, for this and for EngineTelemetry) against the
+ time the block lasts: when rendering uses more than targetLoad of the block the allowance is cut
+ by a fraction straight away, and it creeps back up a few grains per block once there is room
+ again (additive increase, multiplicative decrease - it settles just under the load the machine
+ can take). Offline renders ignore the timing, so they always get the hard limit and stay
+ deterministic.
+
+ The voices split the allowance between them - counting every voice a note-on in the block may
+ start, so a chord struck from silence does not hand each new voice the whole of it - stretch their
+ spawn interval so their steady-state overlap fits, and fade out their quietest grains if they are
+ still over (GrainPool::cull). The predicted load - the grains the current settings would ask for
+ against the allowance - is shown by the editor's cloud view, which warns once it goes above 1 and
+ grains are being thinned out.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+class GrainBudget
+{
+public:
+    /**
+     @param sampleRate double
+     */
+    void prepare (double sampleRate)
+    {
+        currentSampleRate = sampleRate;
+        allowed = (double) limit;
+    }
+
+    /**
+     sets the hard limit from the "GrainLimit" parameter - audio thread, once per block
+     @param maxGrains int
+     */
+    void setLimit (int maxGrains)
+    {
+        limit = juce::jmax (minGrains, maxGrains);
+        allowed = juce::jmin (allowed, (double) limit);
+    }
+
+    /**
+     Returns the number of grains the instance may keep alive this block
+     */
+    int getAllowedGrains() const
+    {
+        return (int) allowed;
+    }
+
+    /**
+     call when the block has finished rendering - adapts the allowance to the time it took
+     @param renderSeconds double - time spent in processBlock
+     @param numSamples int
+     @param isNonRealtime bool - an offline render always gets the whole limit
+     */
+    void endBlock (double renderSeconds, int numSamples, bool isNonRealtime)
+    {
+        if (isNonRealtime || numSamples <= 0)
+        {
+            allowed = (double) limit;
+            load.store (0.0f, std::memory_order_relaxed);
+            return;
+        }
+
+        const double blockLoad = renderSeconds * currentSampleRate / numSamples;
+        load.store ((float) blockLoad, std::memory_order_relaxed);
+
+        if (blockLoad > targetLoad)
+            allowed = juce::jmax ((double) minGrains, allowed * backOff);
+        else if (blockLoad < targetLoad * 0.75)
+            allowed = juce::jmin ((double) limit, allowed + recoveryPerBlock);
+    }
+
+    /**
+     publishes the grains the current settings would keep alive, summed over the voices
+     @param predictedGrains double
+     */
+    void setPredictedGrains (double predictedGrains)
+    {
+        predictedLoad.store (float (predictedGrains / juce::jmax (1.0, allowed)), std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the predicted grains over the allowance - above 1 the limiter is thinning the cloud. Safe from any thread.
+     */
+    float getPredictedLoad() const
+    {
+        return predictedLoad.load (std::memory_order_relaxed);
+    }
+
+    /**
+     Returns the share of the last block's time spent rendering it. Safe from any thread.
+     */
+    float getMeasuredLoad() const
+    {
+        return load.load (std::memory_order_relaxed);
+    }
+
+    static constexpr int minGrains = 16;
+
+private:
+    static constexpr double targetLoad = 0.6;        // of the block duration
+    static constexpr double backOff = 0.8;           // allowance kept after an over-budget block
+    static constexpr double recoveryPerBlock = 4.0;  // grains given back per comfortable block
+
+    double currentSampleRate = 44100.0;
+    int limit = 1024;
+    double allowed = 1024.0;
+
+    std::atomic<float> load { 0.0f };
+    std::atomic<float> predictedLoad { 0.0f };
+};
@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    GrainCloudView.h
+    Created: 21 Oct 2026 3:31:09pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainCloudView - the live grain cloud over the source waveform
+
+ Every grain is drawn as a bar from where its read head starts to where it ends, at the height of
+ its pan (left at the top), brighter the louder it is, with a dot for the read head. In Sample
+ mode the bars sit over an outline of the sample; in Delay mode the width is the delay line, the
+ write head on the left.
+
+ The view only ever learns about grains from the voices' GrainEventQueues, drained on a 60 Hz
+ timer: it never locks or reads the engine's grain state. Reporting is switched on while the view
+ exists. Read head positions are extrapolated from when a spawn arrived, and a grain whose retire
+ was lost (a full queue) is dropped once it should have finished.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <unordered_map>
+#include "PluginProcessor.h"
+
+class GrainCloudView : public juce::Component, private juce::Timer
+{
+public:
+    explicit GrainCloudView (TryGranulatorAudioProcessor& p) : audioProcessor (p)
+    {
+        setOpaque (true);
+
+        // events left over from the last time the editor was open belong to grains that are long gone
+        for (int v = 0; v < audioProcessor.getNumGrainVoices(); ++v)
+            if (auto* events = audioProcessor.getGrainEvents (v))
+                while (events->pop (scratch.data(), (int) scratch.size()) > 0) {}
+
+        audioProcessor.setGrainEventsEnabled (true);
+        startTimerHz (60);
+    }
+
+    ~GrainCloudView() override
+    {
+        stopTimer();
+        audioProcessor.setGrainEventsEnabled (false);
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        g.fillAll (juce::Colour (0xff15171c));
+
+        auto bounds = getLocalBounds().toFloat().reduced (6.0f);
+        auto statusArea = bounds.removeFromBottom (18.0f);
+        const float width = bounds.getWidth();
+        const float centre = bounds.getCentreY();
+        const float halfHeight = bounds.getHeight() * 0.5f;
+
+        // source outline, or the delay line axis
+        if (lastMode == 1)
+        {
+            g.setColour (juce::Colour (0xff3b4250));
+            for (int x = 0; x < (int) width; ++x)
+            {
+                const auto bin = (size_t) juce::jmin (SampleOverview::numBins - 1, int (x * SampleOverview::numBins / width));
+                g.drawVerticalLine ((int) bounds.getX() + x, centre - waveMax[bin] * halfHeight, centre - waveMin[bin] * halfHeight + 1.0f);
+            }
+        }
+        else
+        {
+            g.setColour (juce::Colour (0xff3b4250));
+            g.drawHorizontalLine ((int) centre, bounds.getX(), bounds.getRight());
+            g.setFont (juce::FontOptions (12.0f));
+            g.drawText ("write head", bounds.withHeight (14.0f), juce::Justification::topLeft);
+        }
+
+        // grains - capped, so a huge cloud can't stall the message thread
+        const double now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        int numDrawn = 0;
+
+        for (const auto& entry : grains)
+        {
+            if (++numDrawn > maxDrawnGrains)
+                break;
+
+            const auto& grain = entry.second;
+            const float progress = juce::jlimit (0.0f, 1.0f, float (now - grain.born) / juce::jmax (grain.duration, 1.0e-3f));
+            const float x0 = bounds.getX() + grain.position * width;
+            const float x1 = x0 + grain.span * width;
+            const float head = x0 + (x1 - x0) * progress;
+            const float y = centre - grain.pan * halfHeight * 0.9f;
+
+            g.setColour (voiceColour (grain.voice).withAlpha (0.2f + 0.6f * juce::jmin (1.0f, grain.level)));
+            g.fillRect (juce::Rectangle<float> (juce::jmin (x0, x1), y - 1.5f, juce::jmax (2.0f, std::abs (x1 - x0)), 3.0f));
+            g.fillEllipse (head - 2.5f, y - 2.5f, 5.0f, 5.0f);
+        }
+
+        // engine summary from the telemetry
+        const auto& summary = audioProcessor.getTelemetryMonitor().getSummary();
+        g.setColour (juce::Colours::lightgrey);
+        g.setFont (juce::FontOptions (12.0f));
+        g.drawText (juce::String (summary.activeGrains) + " grains   "
+                        + juce::String (summary.activeVoices) + " voices   "
+                        + "load " + juce::String (summary.load * 100.0, 0) + "% (peak " + juce::String (summary.peakLoad * 100.0, 0) + "%)   "
+                        + juce::String (summary.spawnsPerSecond, 0) + " spawns/s   "
+                        + juce::String (summary.cullsPerSecond, 0) + " culls/s",
+                    statusArea, juce::Justification::centredLeft);
+
+        // the grains the settings ask for against the budget - above 100% the limiter is thinning the cloud
+        const float predictedLoad = audioProcessor.getPredictedGrainLoad();
+        g.setColour (predictedLoad > 1.0f ? juce::Colours::orange : juce::Colours::lightgrey);
+        g.drawText ((predictedLoad > 1.0f ? "over grain limit - thinning, asks " : "grain budget ")
+                        + juce::String (predictedLoad * 100.0f, 0) + "%",
+                    statusArea, juce::Justification::centredRight);
+    }
+
+private:
+    struct VisualGrain
+    {
+        float position, span, duration, pan, level;
+        double born;    // when the spawn reached the view, in seconds
+        uint16_t voice;
+    };
+
+    void timerCallback() override
+    {
+        const double now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+
+        for (int v = 0; v < audioProcessor.getNumGrainVoices(); ++v)
+        {
+            auto* events = audioProcessor.getGrainEvents (v);
+            if (events == nullptr)
+                continue;
+
+            int numRead;
+            while ((numRead = events->pop (scratch.data(), (int) scratch.size())) > 0)
+                for (int i = 0; i < numRead; ++i)
+                    apply (scratch[(size_t) i], now);
+        }
+
+        // a grain whose retire event was lost goes once it should have finished
+        for (auto it = grains.begin(); it != grains.end();)
+        {
+            if (now - it->second.born > it->second.duration + 0.25)
+                it = grains.erase (it);
+            else
+                ++it;
+        }
+
+        const auto& overview = audioProcessor.getSampleOverview();
+        if (overview.getVersion() != overviewVersion)
+        {
+            overviewVersion = overview.getVersion();
+            overview.copyTo (waveMin, waveMax);
+        }
+
+        repaint();
+    }
+
+    void apply (const GrainEvent& event, double now)
+    {
+        const auto key = (uint64_t (event.voice) << 32) | event.id;
+
+        if (event.type == GrainEvent::spawn)
+        {
+            grains[key] = { event.position, event.span, event.duration, event.pan, event.level, now, event.voice };
+            lastMode = event.mode;
+        }
+        else if (event.type == GrainEvent::retire)
+        {
+            grains.erase (key);
+        }
+        else
+        {
+            for (auto it = grains.begin(); it != grains.end();)
+            {
+                if (it->second.voice == event.voice)
+                    it = grains.erase (it);
+                else
+                    ++it;
+            }
+        }
+    }
+
+    static juce::Colour voiceColour (int voice)
+    {
+        static const juce::Colour colours[] = { juce::Colour (0xff4fc3f7), juce::Colour (0xffffb74d),
+                                                juce::Colour (0xff81c784), juce::Colour (0xffe57373) };
+        return colours[voice % 4];
+    }
+
+    static constexpr int maxDrawnGrains = 2000;
+
+    TryGranulatorAudioProcessor& audioProcessor;
+    std::array<GrainEvent, 256> scratch;
+    std::unordered_map<uint64_t, VisualGrain> grains;
+    int lastMode = 1;
+
+    std::vector<float> waveMin = std::vector<float> ((size_t) SampleOverview::numBins, 0.0f);
+    std::vector<float> waveMax = std::vector<float> ((size_t) SampleOverview::numBins, 0.0f);
+    int overviewVersion = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainCloudView)
+};
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    GrainEvents.h
+    Created: 21 Oct 2026 2:05:44pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainEventQueue - grain spawns and retires of one voice, on their way to the editor
+
+ A single-producer single-consumer ring of compact GrainEvent records (juce::AbstractFifo over a
+ fixed array). The voice is the only writer, so voices rendering in parallel each have their own
+ queue; the editor's timer is the only reader. Nothing is pushed unless the editor has switched
+ the queue on, so with the editor closed the voice pays one relaxed load per block. Pushing never
+ blocks: if the editor falls behind, events are dropped and counted.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+struct GrainEvent
+{
+    enum Type : uint8_t
+    {
+        spawn = 0,
+        retire,     // the grain with this id has finished (or faded out early)
+        clear       // every grain of the voice is gone - a new note started
+    };
+
+    uint8_t type = spawn;
+    uint8_t mode = 0;       // granular mode the grain was spawned in: 0 delay, 1 sample
+    uint16_t voice = 0;
+    uint32_t id = 0;        // per-voice grain id, see GrainPool::getLastAddedId
+    float position = 0.0f;  // start in the source (sample mode) or behind the write head (delay mode), 0-1
+    float span = 0.0f;      // distance the read head covers over the grain, same units, negative when it moves backwards
+    float duration = 0.0f;  // seconds
+    float pan = 0.0f;       // -1 to 1
+    float level = 0.0f;
+};
+
+class GrainEventQueue
+{
+public:
+    static constexpr int capacity = 4096;
+
+    GrainEventQueue() = default;
+
+    /**
+     switches reporting on or off - message thread, normally the editor opening and closing
+     @param shouldReport bool
+     */
+    void setEnabled (bool shouldReport)
+    {
+        enabled.store (shouldReport, std::memory_order_relaxed);
+    }
+
+    /**
+     true while the editor wants grain events - checked by the voice once per block
+     */
+    bool isEnabled() const
+    {
+        return enabled.load (std::memory_order_relaxed);
+    }
+
+    /**
+     adds an event - the voice's render thread only, wait-free
+     @param event const GrainEvent&
+     */
+    void push (const GrainEvent& event)
+    {
+        const auto scope = fifo.write (1);
+        if (scope.blockSize1 > 0)
+            events[(size_t) scope.startIndex1] = event;
+        else
+            numLost.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    /**
+     takes the oldest events out of the queue - one reader only
+     @param dest GrainEvent* - room for maxEvents
+     @param maxEvents int
+     @return the number of events copied
+     */
+    int pop (GrainEvent* dest, int maxEvents)
+    {
+        const auto scope = fifo.read (maxEvents);
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            dest[i] = events[(size_t) (scope.startIndex1 + i)];
+        for (int i = 0; i < scope.blockSize2; ++i)
+            dest[scope.blockSize1 + i] = events[(size_t) (scope.startIndex2 + i)];
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    /**
+     Returns the number of events dropped because the queue was full. Safe from any thread.
+     */
+    uint32_t getNumLost() const
+    {
+        return numLost.load (std::memory_order_relaxed);
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<GrainEvent, (size_t) capacity> events;
+
+    std::atomic<bool> enabled { false };
+    std::atomic<uint32_t> numLost { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (GrainEventQueue)
+};
@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    GrainParameters.h
+    Created: 19 Oct 2026 9:12:44am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainParameters - the voice's parameters, read once per block
+
+ capture() loads every parameter atomic a single time at the start of a block and converts it to
+ the type the render wants, so the per-sample loop only reads plain members. Values derived from
+ several parameters (grain length and spawn interval in samples) are only worked out again when
+ one of their inputs has changed.
+
+ @class ControlRamp - a smoothed control value stepped once per control tick
+
+ The SmoothedValue is advanced a whole tick at a time with skip(); samples inside the tick read a
+ straight line between the two ends, which is exactly what a linear SmoothedValue would have
+ produced sample by sample.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+class GrainParameters
+{
+public:
+    /**
+     function used to connect the parameters from the plugin processor
+     @param apvts juce::AudioProcessorValueTreeState&
+     */
+    void connect (juce::AudioProcessorValueTreeState& apvts)
+    {
+        levelParam = apvts.getRawParameterValue ("Level");
+        positionParam = apvts.getRawParameterValue ("Position");
+        spreadParam = apvts.getRawParameterValue ("stereoWidth");
+        activityParam = apvts.getRawParameterValue ("Activity");
+        envelopeParam = apvts.getRawParameterValue ("Envelope");
+        sparseParam = apvts.getRawParameterValue ("Sparse");
+        lengthParam = apvts.getRawParameterValue ("Length");
+        jitterParam = apvts.getRawParameterValue ("jitter");
+        probParam = apvts.getRawParameterValue ("LevelRand");
+        modeParam = apvts.getRawParameterValue ("Mode");
+        densityParam = apvts.getRawParameterValue ("Density");
+        mixParam = apvts.getRawParameterValue ("Mix");
+        playbackParam = apvts.getRawParameterValue ("Playback");
+        quantiseParam = apvts.getRawParameterValue ("Quantise");
+        quantiseDivisionParam = apvts.getRawParameterValue ("QuantiseDivision");
+        seedParam = apvts.getRawParameterValue ("Seed");
+        schedulingParam = apvts.getRawParameterValue ("Scheduling");
+        interpolationParam = apvts.getRawParameterValue ("Interpolation");
+        grainFeedbackParam = apvts.getRawParameterValue ("GrainFeedback");
+        feedbackParam = apvts.getRawParameterValue ("Feedback");
+    }
+
+    /**
+     takes this block's snapshot - audio thread, once at the start of each block
+     @param sampleRate double
+     @param bpm double - host tempo, used when quantise is on
+     */
+    void capture (double sampleRate, double bpm)
+    {
+        level = levelParam->load();
+        position = positionParam->load();
+        spread = spreadParam->load();
+        activity = (int) activityParam->load();
+        envelopeShape = (int) envelopeParam->load();
+        sparse = sparseParam->load();
+        jitter = jitterParam->load();
+        levelRandomness = probParam->load();
+        mode = (int) modeParam->load();
+        mix = mixParam->load();
+        playbackMode = (int) playbackParam->load();
+        quality = (int) interpolationParam->load();
+        grainFeedback = grainFeedbackParam != nullptr ? grainFeedbackParam->load() : 0.0f;
+        feedback = feedbackParam->load();
+        scheduling = (int) schedulingParam->load();
+
+        const float lengthMs = lengthParam->load();
+        const float densityMs = densityParam->load();
+        const bool quantise = quantiseParam->load() > 0.5f;
+        const int division = (int) quantiseDivisionParam->load();
+
+        if (sampleRate != lastSampleRate || lengthMs != lastLengthMs)
+            lengthSamples = msToSamples (lengthMs, sampleRate);
+
+        if (sampleRate != lastSampleRate || densityMs != lastDensityMs || quantise != lastQuantise
+            || division != lastDivision || bpm != lastBpm)
+            spawnInterval = juce::jmax (1.0, quantise ? quantisedInterval (division, bpm, sampleRate)
+                                                      : double (densityMs) * sampleRate / 1000.0);
+
+        lastSampleRate = sampleRate;
+        lastLengthMs = lengthMs;
+        lastDensityMs = densityMs;
+        lastQuantise = quantise;
+        lastDivision = division;
+        lastBpm = bpm;
+    }
+
+    /**
+     Returns the "Seed" parameter - read directly, a note can start before the block's snapshot is taken
+     */
+    uint32_t getSeed() const
+    {
+        return (uint32_t) seedParam->load();
+    }
+
+    // this block's values
+    float level = 0.0f;
+    float position = 0.0f;
+    float spread = 0.0f;
+    float sparse = 0.0f;
+    float jitter = 0.0f;
+    float levelRandomness = 0.0f;
+    float mix = 0.0f;
+    float grainFeedback = 0.0f;
+    float feedback = 0.0f;
+    int activity = 1;
+    int envelopeShape = 0;
+    int mode = 0;
+    int playbackMode = 0;
+    int quality = 0;
+    int scheduling = 0;       // GrainScheduler::Mode
+
+    // derived, only recomputed when their inputs change
+    int lengthSamples = 1;    // base grain length
+    double spawnInterval = 1.0; // samples between grain spawns, free or quantised to the tempo - not rounded, onsets can fall between samples
+
+private:
+    static int msToSamples (float ms, double sampleRate)
+    {
+        return int ((ms / 1000.0f) * sampleRate);
+    }
+
+    static double quantisedInterval (int divisionIndex, double bpm, double sampleRate)
+    {
+        double msPerQuarter = (60.0 / bpm) * 1000.0;
+
+        // 1 = quarter, 2 = 8th, 4 = 16th
+        int division = 2;
+
+        switch (divisionIndex)
+        {
+            case 0: division = 1; break;  // quarter
+            case 1: division = 2; break;  // eighth
+            case 2: division = 4; break;  // sixteenth
+            default: division = 2; break;
+        }
+
+        return msPerQuarter / division * sampleRate / 1000.0;
+    }
+
+    std::atomic<float>* levelParam = nullptr;
+    std::atomic<float>* positionParam = nullptr;
+    std::atomic<float>* spreadParam = nullptr;
+    std::atomic<float>* envelopeParam = nullptr;
+    std::atomic<float>* activityParam = nullptr;
+    std::atomic<float>* sparseParam = nullptr;
+    std::atomic<float>* jitterParam = nullptr;
+    std::atomic<float>* lengthParam = nullptr;
+    std::atomic<float>* probParam = nullptr;
+    std::atomic<float>* modeParam = nullptr;
+    std::atomic<float>* densityParam = nullptr;
+    std::atomic<float>* mixParam = nullptr;
+    std::atomic<float>* playbackParam = nullptr;
+    std::atomic<float>* quantiseParam = nullptr;
+    std::atomic<float>* quantiseDivisionParam = nullptr;
+    std::atomic<float>* grainFeedbackParam = nullptr;
+    std::atomic<float>* feedbackParam = nullptr;
+    std::atomic<float>* seedParam = nullptr;
+    std::atomic<float>* interpolationParam = nullptr;
+    std::atomic<float>* schedulingParam = nullptr;
+
+    // inputs of the derived values, as of the last capture
+    double lastSampleRate = 0.0;
+    double lastBpm = 0.0;
+    float lastLengthMs = -1.0f;
+    float lastDensityMs = -1.0f;
+    bool lastQuantise = false;
+    int lastDivision = -1;
+};
+
+class ControlRamp
+{
+public:
+    /**
+     @param sampleRate double
+     @param rampSeconds double - time to glide to a new target
+     @param initialValue float
+     */
+    void reset (double sampleRate, double rampSeconds, float initialValue)
+    {
+        smoothed.reset (sampleRate, rampSeconds);
+        smoothed.setCurrentAndTargetValue (initialValue);
+        start = initialValue;
+        step = 0.0f;
+    }
+
+    /**
+     moves the ramp on by one control tick towards target
+     @param target float
+     @param tickLength int - samples in the tick
+     */
+    void advance (float target, int tickLength)
+    {
+        start = smoothed.getCurrentValue();
+        smoothed.setTargetValue (target);
+        step = (smoothed.skip (tickLength) - start) / float (tickLength);
+    }
+
+    /**
+     Returns the value at a sample of the current tick
+     @param offset int - 0 is the first sample of the tick
+     */
+    float at (int offset) const
+    {
+        return start + step * float (offset + 1);
+    }
+
+private:
+    juce::SmoothedValue<float> smoothed;
+    float start = 0.0f;
+    float step = 0.0f;
+};
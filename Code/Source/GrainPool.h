@@ -0,0 +1,577 @@
+/*
+  ==============================================================================
+
+    GrainPool.h
+    Created: 16 Oct 2026 11:02:17am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainPool - structure-of-arrays store for the live grains of one voice
+
+ Every grain field lives in its own contiguous array, so the kernel reads a grain's constants
+ straight out of them. It renders grain by grain and runs along each grain's samples one
+ juce::dsp::SIMDRegister at a time: every lane is a different sample of the same grain, so gain,
+ pan, fades and read increment are plain broadcasts. Only the per-sample table and source reads
+ are done lane by lane (there is no gather instruction to lean on). Source interpolation (see
+ Interpolation.h), envelope interpolation, fade, gain and pan run on whole registers, and each
+ register is added straight into per-sample accumulators, so there is no sum across lanes.
+ The accumulators are added to the output once per block.
+
+ Sample-mode grains read from one level of the source's decimated pyramid, or cross-fade between
+ two neighbouring levels (see GrainSampleSource::getLevelFor): a blended grain gathers from both
+ levels in the same pass and mixes the two interpolated registers by its blend before the envelope,
+ so a fast grain costs one extra gather rather than a second run over the block.
+
+ Delay-mode grains also feed back into the delay line; the kernel sums that mono feedback from
+ the same interpolated, enveloped samples it writes to the output, so there is no second pass.
+
+ Storage is allocated once in prepare() for the worst case, so spawning and retiring a grain
+ never touches the heap; a grain that doesn't fit is dropped and counted instead. When the voice
+ is over its grain budget, cull() fades out the least audible grains over a few milliseconds.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <limits>
+#include "DelayLine.h"
+#include "EnvelopeTables.h"
+#include "Grain.h"
+#include "Interpolation.h"
+#include "SampleSource.h"
+
+class GrainPool
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+    static constexpr int allSlots = -1;
+
+    /**
+     allocates room for a fixed number of grains - called from prepareToPlay, never while rendering
+     @param maxGrains int - worst-case number of overlapping grains
+     @param maxBlockSize int - longer blocks are rendered in pieces of this size
+     */
+    void prepare (int maxGrains, int maxBlockSize)
+    {
+        capacity = juce::jmax (1, maxGrains);
+
+        // whole registers, plus room to move the start up to the next register boundary
+        busSize = (juce::jmax (1, maxBlockSize) + lanes - 1) / lanes * lanes;
+        for (int bus = 0; bus < numBuses; ++bus)
+        {
+            busStorage[bus].allocate ((size_t) (busSize + lanes), true);
+            buses[bus] = Vec::getNextSIMDAlignedPtr (busStorage[bus].get());
+        }
+
+        for (auto* array : { &readIncrement, &gainL, &gainR, &level })
+            array->allocate ((size_t) capacity, true);
+
+        readStart.allocate ((size_t) capacity, true);
+        sourceSlot.allocate ((size_t) capacity, true);
+        sourceLevel.allocate ((size_t) capacity, true);
+        levelBlend.allocate ((size_t) capacity, true);
+
+        onset.allocate ((size_t) capacity, true);
+        length.allocate ((size_t) capacity, true);
+        fadeEnd.allocate ((size_t) capacity, true);
+        grainId.allocate ((size_t) capacity, true);
+        envIncrement.allocate ((size_t) capacity, true);
+
+        cullScore.allocate ((size_t) capacity, true);
+        cullOrder.allocate ((size_t) capacity, true);
+
+        numActive = 0;
+    }
+
+    /**
+     adds a freshly spawned grain to the store in O(1)
+     @param grain const Grain& - spawn description of the grain
+     @param readPosition double - first source index: sample index in Sample mode, delay buffer index in Delay mode
+     @param slot int - which of the voice's sample sources the grain reads, see renderBlock
+     @param sampleLevel int - source level the grain reads, readPosition is still in level 0 samples
+     @param blend float - weight of sampleLevel + 1, read alongside it
+     @return false if the pool is full and the grain was dropped
+     */
+    bool add (const Grain& grain, double readPosition, int slot = 0, int sampleLevel = 0, float blend = 0.0f)
+    {
+        if (numActive >= capacity)
+        {
+            numDropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        const auto g = (size_t) numActive++;
+        numSpawned.fetch_add (1, std::memory_order_relaxed);
+        grainId[g] = nextId++;
+        onset[g] = grain.getOnset();
+        length[g] = grain.getLength();
+        fadeEnd[g] = notFading;
+        const double levelScale = 1.0 / double (1 << sampleLevel);
+        readStart[g] = readPosition * levelScale;
+        sourceSlot[g] = (uint8_t) slot;
+        sourceLevel[g] = (uint8_t) sampleLevel;
+        levelBlend[g] = blend;
+        readIncrement[g] = float (grain.getRate() * levelScale);
+        gainL[g] = grain.getLevel() * grain.getLeftGain();
+        gainR[g] = grain.getLevel() * grain.getRightGain();
+        level[g] = grain.getLevel();
+        envIncrement[g] = grain.getEnvIncrement();
+        return true;
+    }
+
+    /**
+     removes every grain that has finished by the given voice time.
+     Each finished grain is overwritten by the last one, so retiring is O(1) per grain;
+     the order of the grains isn't kept, nothing in the render depends on it.
+     @param time int
+     @param onRetire callable taking the uint32_t id of each grain removed
+     */
+    template <typename RetireCallback>
+    void removeFinished (int time, RetireCallback&& onRetire)
+    {
+        for (int i = 0; i < numActive;)
+        {
+            const auto g = (size_t) i;
+
+            if (time <= onset[g] + length[g])
+            {
+                ++i;
+                continue;
+            }
+
+            onRetire (grainId[g]);
+
+            const auto last = (size_t) --numActive;
+            grainId[g] = grainId[last];
+            onset[g] = onset[last];
+            length[g] = length[last];
+            fadeEnd[g] = fadeEnd[last];
+            readStart[g] = readStart[last];
+            sourceSlot[g] = sourceSlot[last];
+            sourceLevel[g] = sourceLevel[last];
+            levelBlend[g] = levelBlend[last];
+            readIncrement[g] = readIncrement[last];
+            gainL[g] = gainL[last];
+            gainR[g] = gainR[last];
+            level[g] = level[last];
+            envIncrement[g] = envIncrement[last];
+        }
+    }
+
+    void removeFinished (int time)
+    {
+        removeFinished (time, [] (uint32_t) {});
+    }
+
+    void clear()
+    {
+        numActive = 0;
+    }
+
+    int size() const
+    {
+        return numActive;
+    }
+
+    int getCapacity() const
+    {
+        return capacity;
+    }
+
+    /**
+     Returns the id given to the most recently added grain - ids count up from 0 for the lifetime of the pool
+     */
+    uint32_t getLastAddedId() const
+    {
+        return nextId - 1;
+    }
+
+    /**
+     true if any live grain was added with the given source slot
+     @param slot int
+     */
+    bool usesSlot (int slot) const
+    {
+        for (size_t g = 0; g < (size_t) numActive; ++g)
+            if (sourceSlot[g] == slot)
+                return true;
+
+        return false;
+    }
+
+    /**
+     fades out the least audible grains until no more than maxGrains are left playing at full level.
+     Grains past the middle of their envelope are ranked by how loud they are now, younger ones by
+     the level they are heading for, so grains on their way out go first.
+     @param maxGrains int
+     @param now int - voice time the grains are ranked at
+     @param fadeStart int - voice time the fades begin, the start of the block about to be rendered
+     @param fadeLength int - samples
+     @param envTable const float* - table of the selected envelope shape
+     @return number of grains culled
+     */
+    int cull (int maxGrains, int now, int fadeStart, int fadeLength, const float* envTable)
+    {
+        int numPlaying = 0;
+
+        for (int i = 0; i < numActive; ++i)
+        {
+            const auto g = (size_t) i;
+
+            if (fadeEnd[g] != notFading)
+                continue;
+
+            const int t = juce::jlimit (0, juce::jmax (0, length[g] - 1), now - onset[g]);
+            cullScore[g] = level[g] * (2 * t < length[g] ? 1.0f : GrainEnvelopeTables::lookup (envTable, uint32_t (t) * envIncrement[g]));
+            cullOrder[(size_t) numPlaying++] = i;
+        }
+
+        const int excess = numPlaying - juce::jmax (0, maxGrains);
+        if (excess <= 0)
+            return 0;
+
+        int* order = cullOrder.get();
+        std::nth_element (order, order + excess, order + numPlaying,
+                          [this] (int a, int b) { return cullScore[(size_t) a] < cullScore[(size_t) b]; });
+
+        fadeScale = 1.0f / float (juce::jmax (1, fadeLength));
+
+        for (int k = 0; k < excess; ++k)
+        {
+            const auto g = (size_t) order[k];
+            fadeEnd[g] = fadeStart + fadeLength;
+            length[g] = juce::jlimit (0, length[g], fadeEnd[g] - onset[g]);
+        }
+
+        numCulled.fetch_add ((uint32_t) excess, std::memory_order_relaxed);
+        return excess;
+    }
+
+    /**
+     number of grains added since the pool was created - safe to read from any thread
+     */
+    uint32_t getNumSpawned() const
+    {
+        return numSpawned.load (std::memory_order_relaxed);
+    }
+
+    /**
+     number of grains faded out early by cull() - safe to read from any thread
+     */
+    uint32_t getNumCulled() const
+    {
+        return numCulled.load (std::memory_order_relaxed);
+    }
+
+    /**
+     number of grains that couldn't be spawned because the pool was full - safe to read from any thread
+     */
+    uint32_t getNumDropped() const
+    {
+        return numDropped.load (std::memory_order_relaxed);
+    }
+
+    /**
+     Renders every grain from the source sample into a block buffer
+     @param output juce::AudioBuffer<float>& - block buffer, sample 0 is blockStart
+     @param levels const GrainSampleSource::Reader* - one reader per source level, GrainSampleSource::maxLevels of them
+     @param blockStart int - voice time of the first sample in the block
+     @param numSamples int
+     @param envTable const float* - table of the selected envelope shape
+     @param gain float - per-block gain shared by all grains (activity scaling)
+     @param quality int - GrainInterpolation::Quality used to read between source samples
+     @param slot int - only render the grains added with this source slot, or allSlots
+     */
+    void renderBlock (juce::AudioBuffer<float>& output, const GrainSampleSource::Reader* levels, int blockStart, int numSamples, const float* envTable, float gain, int quality, int slot = allSlots)
+    {
+        const auto kernel = selectKernel<GrainSampleSource::Reader> (quality, output.getNumChannels() >= 2);
+        (this->*kernel) (output, nullptr, levels, blockStart, numSamples, envTable, gain, slot);
+    }
+
+    /**
+     Renders every grain from the delay buffer into a block buffer, and in the same pass adds
+     their unpanned mono sum into a feedback buffer - what goes back into the delay line is
+     exactly what is heard, envelope included
+     @param output juce::AudioBuffer<float>& - block buffer, sample 0 is blockStart
+     @param feedback float* - block buffer, sample 0 is blockStart
+     @param source const DelayLine&
+     @param blockStart int - voice time of the first sample in the block
+     @param numSamples int
+     @param envTable const float* - table of the selected envelope shape
+     @param gain float - per-block gain shared by all grains (activity scaling)
+     @param quality int - GrainInterpolation::Quality used to read between delay samples
+     */
+    void renderBlock (juce::AudioBuffer<float>& output, float* feedback, const DelayLine& source, int blockStart, int numSamples, const float* envTable, float gain, int quality)
+    {
+        const DelayReader reader { source };
+        const auto kernel = selectKernel<DelayReader> (quality, output.getNumChannels() >= 2);
+        (this->*kernel) (output, feedback, &reader, blockStart, numSamples, envTable, gain, allSlots);
+    }
+
+private:
+    //==============================================================================
+    // Per-lane source access used by the kernel
+
+    // gather (first, lane, l, r) copies numTaps consecutive left and right source samples from
+    // index first into column lane of the tap rows; mono sources fill both rows alike.
+    // Sample mode reads through GrainSampleSource::Reader.
+
+    struct DelayReader
+    {
+        const DelayLine& line;
+
+        template <int numTaps>
+        void gather (juce::int64 first, int lane, float (*l)[lanes], float (*r)[lanes]) const
+        {
+            line.gather<numTaps> (first, &l[0][lane], &r[0][lane], lanes);
+        }
+    };
+
+    //==============================================================================
+    // Everything that is fixed for a whole block is a template parameter of the kernel rather than a
+    // branch inside it: the interpolator, mono or stereo output, and the mode - which is the Reader
+    // type, Delay mode being the one that also renders the feedback bus. The envelope shape needs no
+    // variant, every shape is read through the same table lookup.
+    template <typename Reader>
+    using Kernel = void (GrainPool::*) (juce::AudioBuffer<float>&, float*, const Reader*, int, int, const float*, float, int);
+
+    // picks the kernel once per block; an unknown quality falls back to cubic
+    template <typename Reader>
+    static Kernel<Reader> selectKernel (int quality, bool stereo)
+    {
+        using I = GrainInterpolation;
+
+        static constexpr Kernel<Reader> kernels[I::numQualities][2]
+        {
+            { &GrainPool::renderLanes<I::Nearest, false, Reader>, &GrainPool::renderLanes<I::Nearest, true, Reader> },
+            { &GrainPool::renderLanes<I::Linear,  false, Reader>, &GrainPool::renderLanes<I::Linear,  true, Reader> },
+            { &GrainPool::renderLanes<I::Cubic,   false, Reader>, &GrainPool::renderLanes<I::Cubic,   true, Reader> },
+            { &GrainPool::renderLanes<I::Sinc,    false, Reader>, &GrainPool::renderLanes<I::Sinc,    true, Reader> }
+        };
+
+        if (! juce::isPositiveAndBelow (quality, (int) I::numQualities))
+            quality = I::cubic;
+
+        return kernels[quality][stereo ? 1 : 0];
+    }
+
+    // levels holds one reader per pyramid level in Sample mode, the delay line alone in Delay mode,
+    // where feedback also receives the mono sum of the grains without pan
+    template <typename Interpolator, bool stereo, typename Reader>
+    void renderLanes (juce::AudioBuffer<float>& output, float* feedback, const Reader* levels, int blockStart, int numSamples, const float* envTable, float gain, int slot)
+    {
+        constexpr bool withFeedback = std::is_same<Reader, DelayReader>::value;
+        const int numGrains = size();
+
+        // a block longer than the accumulators is rendered a piece at a time
+        for (int pieceStart = 0; pieceStart < numSamples; pieceStart += busSize)
+        {
+            const int pieceLength = juce::jmin (busSize, numSamples - pieceStart);
+            const int pieceTime = blockStart + pieceStart;
+            const int busLength = (pieceLength + lanes - 1) / lanes * lanes;
+            bool anyGrain = false;
+
+            for (int i = 0; i < numGrains; ++i)
+            {
+                const auto g = (size_t) i;
+
+                // grains of the other slot are skipped
+                if (slot != allSlots && sourceSlot[g] != slot)
+                    continue;
+
+                const int begin = juce::jmax (0, onset[g] - pieceTime);
+                const int end = juce::jmin (pieceLength, onset[g] + length[g] - pieceTime);
+                if (begin >= end)
+                    continue;
+
+                if (! anyGrain)
+                {
+                    for (int bus = 0; bus < numBuses; ++bus)
+                        juce::FloatVectorOperations::clear (buses[bus], busLength);
+
+                    anyGrain = true;
+                }
+
+                const Reader& reader = levels[sourceLevel[g]];
+
+                // only Sample mode has a coarser level to blend in
+                if constexpr (! withFeedback)
+                {
+                    if (levelBlend[g] > 0.0f)
+                    {
+                        renderGrain<Interpolator, stereo, false, true, Reader> (g, reader, &levels[sourceLevel[g] + 1], pieceTime, begin, end, envTable, gain);
+                        continue;
+                    }
+                }
+
+                renderGrain<Interpolator, stereo, withFeedback, false, Reader> (g, reader, nullptr, pieceTime, begin, end, envTable, gain);
+            }
+
+            if (! anyGrain)
+                continue;
+
+            // the one pass over the block that adds the grains to the output
+            juce::FloatVectorOperations::add (output.getWritePointer (0, pieceStart), buses[left], pieceLength);
+
+            if constexpr (stereo)
+                juce::FloatVectorOperations::add (output.getWritePointer (1, pieceStart), buses[right], pieceLength);
+
+            if constexpr (withFeedback)
+                juce::FloatVectorOperations::add (feedback + pieceStart, buses[mono], pieceLength);
+        }
+    }
+
+    // gathers the taps for one register of consecutive read positions, the first at position. The position is
+    // split in double, the lanes step on from it in float
+    template <typename Interpolator, typename Reader>
+    static void gatherRegister (const Reader& reader, double position, float increment, float* frac,
+                                float (*tapsL)[lanes], float (*tapsR)[lanes])
+    {
+        const double base = std::floor (position);
+        const float baseFrac = float (position - base);
+
+        for (int k = 0; k < lanes; ++k)
+        {
+            const float x = baseFrac + float (k) * increment;
+            int whole = (int) x;
+            whole -= x < float (whole) ? 1 : 0;
+            frac[k] = x - float (whole);
+
+            reader.template gather<Interpolator::numTaps> ((juce::int64) base + whole + Interpolator::firstTap, k, tapsL, tapsR);
+        }
+    }
+
+    // one grain over [begin, end) of the accumulators, a register of consecutive samples at a time. The
+    // registers line up with the accumulators, so lanes before begin or from end on are read with a zero envelope.
+    // A blended grain also reads coarser, the next pyramid level down, and mixes it in by its blend
+    template <typename Interpolator, bool stereo, bool withFeedback, bool blended, typename Reader>
+    void renderGrain (size_t g, const Reader& reader, const Reader* coarser, int pieceTime, int begin, int end, const float* envTable, float gain)
+    {
+        constexpr int numTaps = Interpolator::numTaps;
+        constexpr float envFracScale = 1.0f / float (1u << GrainEnvelopeTables::fracBits);
+        constexpr uint32_t envFracMask = (1u << GrainEnvelopeTables::fracBits) - 1u;
+
+        // everything that is the same for every sample of the grain
+        const auto laneGainL = Vec::expand ((stereo ? gainL[g] : level[g]) * gain);
+        const auto laneGainR = Vec::expand (gainR[g] * gain);
+        const auto laneGainMono = Vec::expand (0.5f * level[g] * gain);
+        const float increment = readIncrement[g];
+        const auto blend = Vec::expand (levelBlend[g]);
+        const uint32_t envStep = envIncrement[g];
+        const bool fading = fadeEnd[g] != notFading;
+        const int onsetTime = onset[g];
+
+        alignas (Vec::SIMDRegisterSize) float laneIndex[lanes];
+        for (int k = 0; k < lanes; ++k)
+            laneIndex[k] = float (k);
+
+        const auto laneOffsets = Vec::fromRawArray (laneIndex);
+
+        for (int i = begin - begin % lanes; i < end; i += lanes)
+        {
+            alignas (Vec::SIMDRegisterSize) float env0[lanes], env1[lanes], envFrac[lanes], frac[lanes];
+            alignas (Vec::SIMDRegisterSize) float tapsL[numTaps][lanes], tapsR[numTaps][lanes];
+
+            const int t = pieceTime + i - onsetTime;
+            const double position = readStart[g] + double (t) * readIncrement[g];
+            uint32_t phase = uint32_t (t) * envStep;
+
+            for (int k = 0; k < lanes; ++k, phase += envStep)
+            {
+                const float inside = i + k >= begin && i + k < end ? 1.0f : 0.0f;
+                const uint32_t index = phase >> GrainEnvelopeTables::fracBits;
+                env0[k] = envTable[index] * inside;
+                env1[k] = envTable[index + 1] * inside;
+                envFrac[k] = float (phase & envFracMask) * envFracScale;
+            }
+
+            gatherRegister<Interpolator> (reader, position + Interpolator::positionOffset, increment, frac, tapsL, tapsR);
+
+            // envelope, fade, source interpolation, gain and pan for the whole register
+            const auto e0 = Vec::fromRawArray (env0);
+            auto env = e0 + Vec::fromRawArray (envFrac) * (Vec::fromRawArray (env1) - e0);
+
+            // culled grains ramp down to their new end
+            if (fading)
+                env *= Vec::min (Vec::expand (1.0f), (Vec::expand (float (fadeEnd[g] - (pieceTime + i))) - laneOffsets) * fadeScale);
+
+            // the coarser level runs at half the rate, so its positions and step are halved
+            alignas (Vec::SIMDRegisterSize) float coarseFrac[blended ? lanes : 1];
+            alignas (Vec::SIMDRegisterSize) float coarseL[blended ? numTaps : 1][lanes], coarseR[blended ? numTaps : 1][lanes];
+
+            if constexpr (blended)
+                gatherRegister<Interpolator> (*coarser, position * 0.5 + Interpolator::positionOffset, increment * 0.5f, coarseFrac, coarseL, coarseR);
+
+            auto interpolate = [&] (const float (*taps)[lanes], const float (*coarseTaps)[lanes])
+            {
+                auto value = Interpolator::interpolate (taps, frac);
+
+                if constexpr (blended)
+                    value += (Interpolator::interpolate (coarseTaps, coarseFrac) - value) * blend;
+
+                return value * env;
+            };
+
+            const auto srcL = interpolate (tapsL, coarseL);
+            float* busL = buses[left] + i;
+            (Vec::fromRawArray (busL) + srcL * laneGainL).copyToRawArray (busL);
+
+            if constexpr (stereo || withFeedback)
+            {
+                const auto srcR = interpolate (tapsR, coarseR);
+
+                if constexpr (stereo)
+                {
+                    float* busR = buses[right] + i;
+                    (Vec::fromRawArray (busR) + srcR * laneGainR).copyToRawArray (busR);
+                }
+
+                if constexpr (withFeedback)
+                {
+                    float* busMono = buses[mono] + i;
+                    (Vec::fromRawArray (busMono) + (srcL + srcR) * laneGainMono).copyToRawArray (busMono);
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    // one entry per live grain, all arrays share the same index and hold capacity entries
+    juce::HeapBlock<int> onset;
+    juce::HeapBlock<int> length;
+    juce::HeapBlock<int> fadeEnd;           // voice time a culled grain has faded out by, notFading otherwise
+    juce::HeapBlock<double> readStart;      // read phase at the grain onset - double, so long sources keep sample accuracy
+    juce::HeapBlock<uint8_t> sourceSlot;    // which of the voice's sample sources the grain reads
+    juce::HeapBlock<uint8_t> sourceLevel;   // pyramid level of the source, readStart and readIncrement are in its samples
+    juce::HeapBlock<float> levelBlend;      // weight of the next level down, mixed in as the grain is rendered
+    juce::HeapBlock<float> readIncrement;   // read phase step per sample (signed playback rate)
+    juce::HeapBlock<float> gainL;           // level * left pan gain
+    juce::HeapBlock<float> gainR;           // level * right pan gain
+    juce::HeapBlock<float> level;
+    juce::HeapBlock<uint32_t> envIncrement; // fixed-point envelope phase step
+    juce::HeapBlock<uint32_t> grainId;      // only read to report spawns and retires to the editor
+
+    // scratch space for cull(), one entry per grain
+    juce::HeapBlock<float> cullScore;
+    juce::HeapBlock<int> cullOrder;
+
+    // per-sample accumulators of the kernel, register-aligned, busSize samples each
+    enum Bus { left = 0, right, mono, numBuses };
+    juce::HeapBlock<float> busStorage[numBuses];
+    float* buses[numBuses] {};
+    int busSize = 0;
+
+    static constexpr int notFading = std::numeric_limits<int>::max();
+    float fadeScale = 1.0f;
+
+    int numActive = 0;
+    int capacity = 0;
+    uint32_t nextId = 0;
+    std::atomic<uint32_t> numSpawned { 0 };
+    std::atomic<uint32_t> numDropped { 0 };
+    std::atomic<uint32_t> numCulled { 0 };
+};
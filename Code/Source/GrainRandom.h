@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    GrainRandom.h
+    Created: 16 Oct 2026 1:40:52pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainRandom - per-voice xoshiro128** generator for grain randomisation
+
+ Each voice owns one, so there is no shared state between voices or threads and no lock.
+ Seeding with the same values replays exactly the same sequence of grains.
+ Draws are produced in batches: nextUnit()/nextBipolar() pop from a small buffer that is
+ refilled by fill() in one go, and fill() can also be used directly for a whole block.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+
+class GrainRandom
+{
+public:
+    GrainRandom()
+    {
+        setSeed (0);
+    }
+
+    /**
+     restarts the sequence from a seed
+     @param seed uint32_t - value of the "Seed" parameter
+     @param stream uint32_t - separates generators sharing a seed (e.g. voice index and note count)
+     */
+    void setSeed (uint32_t seed, uint32_t stream = 0)
+    {
+        // splitmix64 expands the seed into a well-mixed, never all-zero state
+        uint64_t x = (uint64_t (seed) << 32) | stream;
+
+        for (size_t i = 0; i < state.size(); i += 2)
+        {
+            auto z = (x += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            z ^= z >> 31;
+            state[i] = uint32_t (z);
+            state[i + 1] = uint32_t (z >> 32);
+        }
+
+        cursor = batchSize;
+    }
+
+    uint32_t nextUInt()
+    {
+        const uint32_t result = rotl (state[1] * 5, 7) * 9;
+        const uint32_t t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl (state[3], 11);
+
+        return result;
+    }
+
+    /**
+     fills a buffer with uniform values in [0, 1)
+     @param dest float*
+     @param num int
+     */
+    void fill (float* dest, int num)
+    {
+        for (int i = 0; i < num; ++i)
+            dest[i] = float (nextUInt() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /**
+     Returns a uniform value in [0, 1)
+     */
+    float nextUnit()
+    {
+        if (cursor == batchSize)
+        {
+            fill (batch.data(), batchSize);
+            cursor = 0;
+        }
+
+        return batch[(size_t) cursor++];
+    }
+
+    /**
+     Returns a uniform value in [-1, 1)
+     */
+    float nextBipolar()
+    {
+        return nextUnit() * 2.0f - 1.0f;
+    }
+
+private:
+    static uint32_t rotl (uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    static constexpr int batchSize = 64;
+
+    std::array<uint32_t, 4> state {};
+    std::array<float, batchSize> batch {};
+    int cursor = batchSize;
+};
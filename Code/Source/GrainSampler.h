@@ -1,7 +1,15 @@
+#pragma once
 
 #include <JuceHeader.h>
 #include "DelayLine.h"
 #include "Grain.h"
+#include "GrainEvents.h"
+#include "GrainParameters.h"
+#include "GrainPool.h"
+#include "GrainRandom.h"
+#include "GrainScheduler.h"
+#include "SampleSource.h"
+#include "VoiceWorkerPool.h"
 
 // =================================================== Grain Sound =================================================================================
 
@@ -33,24 +41,134 @@ public:
 /**
  Represents a voice that a Synthesiser can use to play.
  
- GrainVoice class for MIDI-triggered grain playback
+ GrainVoice class for MIDI-triggered grain playback.
+ Voices can be rendered on different threads at once, so each one starts on its own cache line.
  */
-class GrainVoice : public juce::SynthesiserVoice
+class alignas (64) GrainVoice : public juce::SynthesiserVoice
 {
 public:
-    GrainVoice() {
+    /**
+     Allocates everything the voice uses while rendering, so the audio thread never has to - called from prepareToPlay
+     
+     @param sampleRate double
+     @param samplesPerBlock int
+     @param numChannels int
+     @param maxGrains int - worst-case number of overlapping grains in this voice
+     */
+    void prepare (double sampleRate, int samplesPerBlock, int numChannels, int maxGrains)
+    {
+        // a render that starts from prepareToPlay replays the same random sequence
+        noteCount = 0;
         
-        maxDelaySize = getSampleRate() * 3;
-        delayLine.setMaxSize (maxDelaySize);
+        maxDelaySize = int (sampleRate * 3);
+        cullFadeLength = juce::jmax (1, int (sampleRate * 0.005)); // 5 ms, short enough to free the budget quickly without a click
+        delayLine.setMaxSize (maxDelaySize, 2); // stereo frames, so delay grains keep the image of the source
         
-        smoothSparse.reset(getSampleRate(), 0.1);
-        smoothSparse.setCurrentAndTargetValue(0.0f);
+        grains.prepare (maxGrains, samplesPerBlock);
+        dryBuffer.setSize (numChannels, samplesPerBlock);
+        wetBuffer.setSize (numChannels, samplesPerBlock);
+        feedbackBuffer.assign ((size_t) samplesPerBlock, 0.0f);
         
-        smoothedMix.reset(getSampleRate(), 0.1);
-        smoothedMix.setCurrentAndTargetValue(0.0f);
+        smoothSparse.reset(sampleRate, 0.1, 0.0f);
+        smoothedMix.reset(sampleRate, 0.1, 0.0f);
+        smoothedFeedback.reset(sampleRate, 0.1, 0.0f);
+    }
+    
+    /**
+     Sets which voice of the synth this is, so voices sharing a seed still get their own random sequence
+     
+     @param index int
+     */
+    void setVoiceIndex (int index)
+    {
+        voiceIndex = (uint32_t) index;
+    }
+    
+    /**
+     the sources the voice still reads, for the sample loader - audio thread, after setSampleSource
+     
+     @param playing const GrainSampleSource*& - the one new grains spawn from, nullptr if none
+     @param retiring const GrainSampleSource*& - the previous one while its grains finish, otherwise nullptr
+     */
+    void getSampleSources (const GrainSampleSource*& playing, const GrainSampleSource*& retiring) const
+    {
+        playing = sampleSource.get();
+        retiring = retiringSource.get();
+    }
+    
+    /**
+     where the voice reads the source next, for the page warmer - audio thread, after the voice has rendered
+     
+     @param dryHead juce::int64& - source sample of the dry signal, -1 while no note plays
+     @param delayInput juce::int64& - source sample fed into the delay line, -1 while no note plays
+     */
+    void getSourceReadHeads (juce::int64& dryHead, juce::int64& delayInput) const
+    {
+        dryHead = delayInput = -1;
+        
+        if (! noteOn || sampleSource == nullptr || sampleSource->getLengthInSamples() <= 0)
+            return;
         
-        smoothedFeedback.reset(getSampleRate(), 0.1);
-        smoothedFeedback.setCurrentAndTargetValue(0.0f);
+        dryHead = (juce::int64) dryReadHeads[0];
+        delayInput = currentSampleIndex % sampleSource->getLengthInSamples();
+    }
+    
+    /**
+     Returns the number of grains currently alive in this voice
+     */
+    int getNumActiveGrains() const
+    {
+        return grains.size();
+    }
+    
+    /**
+     Sets this voice's share of the instance's grain budget - audio thread, before the voice renders
+     
+     @param maxGrains int
+     */
+    void setGrainBudget (int maxGrains)
+    {
+        grainBudget = juce::jmax (1, maxGrains);
+    }
+    
+    /**
+     Returns the number of grains the current settings keep alive on average, 0 when the voice is silent - audio thread
+     */
+    double getPredictedGrains() const
+    {
+        return isVoiceActive() && noteOn ? predictedGrains : 0.0;
+    }
+    
+    /**
+     Returns the number of grains this voice has spawned
+     */
+    uint32_t getNumSpawnedGrains() const
+    {
+        return grains.getNumSpawned();
+    }
+    
+    /**
+     Returns the queue this voice reports its grains to while the editor is open
+     */
+    GrainEventQueue& getGrainEvents()
+    {
+        return grainEvents;
+    }
+    
+    /**
+     Returns the number of grains faded out early to stay within the grain budget
+     */
+    uint32_t getNumCulledGrains() const
+    {
+        return grains.getNumCulled();
+    }
+    
+    /**
+     Returns the number of grains dropped because the voice's grain pool was full
+     */
+    uint32_t getNumDroppedGrains() const
+    {
+        return grains.getNumDropped();
     }
     
     /**
@@ -60,23 +178,7 @@ public:
      */
     void connectParam(juce::AudioProcessorValueTreeState& apvts)
     {
-        levelParam = apvts.getRawParameterValue("Level");
-        positionParam = apvts.getRawParameterValue ("Position");
-        spreadParam = apvts.getRawParameterValue("stereoWidth");
-        activityParam = apvts.getRawParameterValue ("Activity");
-        envelopeParam = apvts.getRawParameterValue ("Envelope");
-        sparseParam = apvts.getRawParameterValue ("Sparse");
-        lengthParam = apvts.getRawParameterValue ("Length");
-        jitterParam = apvts.getRawParameterValue("jitter");
-        probParam = apvts.getRawParameterValue("LevelRand");
-        modeParam = apvts.getRawParameterValue ("Mode");
-        densityParam = apvts.getRawParameterValue ("Density");
-        mixParam = apvts.getRawParameterValue ("Mix");
-        playbackParam = apvts.getRawParameterValue ("Playback");
-        quantiseParam = apvts.getRawParameterValue("Quantise");
-        quantiseDivisionParam = apvts.getRawParameterValue("QuantiseDivision");
-        grainFeedbackParam = apvts.getRawParameterValue("GrainFeedback");
-        feedbackParam = apvts.getRawParameterValue("Feedback");
+        params.connect (apvts);
     }
     
     /**
@@ -111,15 +213,22 @@ public:
     {
         // basic grain setup
         grains.clear();
+        if (grainEvents.isEnabled())
+            reportClear();
+        retiringSource = nullptr; // its grains are gone with the rest
         
-        dryReadHeads.clear();
-        dryReadHeads.resize (sampleBuffer->getNumChannels(), 0.0f);
+        std::fill (dryReadHeads.begin(), dryReadHeads.end(), 0.0);
 
 
         noteOn = true;
         
+        // reseed from the "Seed" parameter; voice index and note count keep voices and repeated notes distinct
+        random.setSeed (params.getSeed(), (voiceIndex << 24) ^ noteCount++);
+        
         currentSampleIndex = 0;
-        density = 500; //set just for now
+        
+        // each voice starts its grains at its own point of the first interval (golden-ratio steps spread any number of voices evenly)
+        scheduler.reset (0.0, std::fmod (voiceIndex * 0.6180339887, 1.0));
         playbackRate = std::pow (2.0f, (midiNoteNumber - 60) / 12.0f);
         
         envelope.setSampleRate(getSampleRate());
@@ -150,338 +259,618 @@ public:
     }
     
     /**
-     Main audio processing loop for the voice
+     Main audio processing loop for the voice. A block longer than the one prepared for is rendered
+     in pieces of the prepared size, so the voice's buffers are never resized on the audio thread.
      
      @param outputBuffer juce::AudioBuffer<float>&
      @param startSample int
      @param numSamples int
      */
     void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override
+    {
+        const int maxPieceLength = dryBuffer.getNumSamples();
+        
+        // not prepared yet
+        if (maxPieceLength == 0)
+            return;
+        
+        for (int pieceStart = startSample; pieceStart < startSample + numSamples; pieceStart += maxPieceLength)
+            renderPiece (outputBuffer, pieceStart, juce::jmin (maxPieceLength, startSample + numSamples - pieceStart));
+    }
+    
+    /**
+     Sets the source from which new grains will be generated - the voice reads it through one Reader per pyramid level.
+     Called by the processor at the start of every block, on the audio thread, so it never allocates.
+     Grains already playing keep reading the source they were spawned from, and the voice holds on to
+     that source until the last of them has finished. If a third source arrives before then, the voice
+     stays on its current one and picks the new one up on a later call.
+     
+     @param source const GrainSampleSource::Ptr&
+     */
+    void setSampleSource (const GrainSampleSource::Ptr& source)
+    {
+        // dropping a reference here never frees anything - SampleLoader keeps every source until the audio thread is done with it
+        if (retiringSource != nullptr && ! grains.usesSlot (1 - sourceSlot))
+            retiringSource = nullptr;
+        
+        if (source == sampleSource)
+            return;
+        
+        if (sampleSource != nullptr && grains.usesSlot (sourceSlot))
+        {
+            if (retiringSource != nullptr)
+                return;
+            
+            retiringSource = sampleSource;
+            retiringReaders = sourceReaders;
+            sourceSlot = 1 - sourceSlot;
+        }
+        
+        sampleSource = source;
+        for (int level = 0; level < GrainSampleSource::maxLevels; ++level)
+            sourceReaders[(size_t) level] = source != nullptr ? source->getReader (level) : GrainSampleSource::Reader();
+        
+        // one dry read head per source channel (stereo at most); heads past the end of a shorter source restart
+        numDryReadHeads = source != nullptr ? juce::jlimit (1, (int) dryReadHeads.size(), source->getNumChannels()) : 1;
+        const double lastHead = source != nullptr ? double (source->getLengthInSamples() - 1) : 0.0;
+        
+        for (auto& readHead : dryReadHeads)
+            if (readHead >= lastHead)
+                readHead = 0.0;
+    }
+    
+    /**
+     Sets the pointer to the shared envelope tables that every grain of this voice reads from
+     
+     @param tables const GrainEnvelopeTables*
+     */
+    void setEnvelopeTables (const GrainEnvelopeTables* tables)
+    {
+        envelopeTables = tables;
+    }
+    
+    /**
+     MIDI pitch wheel handler
+     */
+    void pitchWheelMoved (int) override
+    {}
+    
+    /**
+     MIDI controller handler
+     */
+    void controllerMoved (int, int) override
+    {}
+
+private:
+    /**
+     renders up to the prepared block size - everything the voice does in a block happens here
+     
+     @param outputBuffer juce::AudioBuffer<float>&
+     @param startSample int
+     @param numSamples int - no more than the block size given to prepare()
+     */
+    void renderPiece (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
     {
         // check if the note is active
-        if (!noteOn || sampleBuffer == nullptr)
+        if (!noteOn || sampleSource == nullptr || envelopeTables == nullptr)
             return;
         
-        // prepare dry buffer for blending into the mix
-        juce::AudioBuffer<float> dryBuffer;
-        dryBuffer.setSize (outputBuffer.getNumChannels(), outputBuffer.getNumSamples());
-        dryBuffer.clear();
+        // every parameter is read here, once - the loops below only see the snapshot
+        params.capture (getSampleRate(), currentBpm);
+        reportGrains = grainEvents.isEnabled();
+        
+        // channels beyond the ones prepared for are left alone
+        const int numChannels = juce::jmin (outputBuffer.getNumChannels(), dryBuffer.getNumChannels());
+        
+        // dry buffer for blending into the mix, and the grains of this voice in their own block buffer, sample 0 = startSample
+        for (int ch = 0; ch < dryBuffer.getNumChannels(); ++ch)
+        {
+            dryBuffer.clear (ch, 0, numSamples);
+            wetBuffer.clear (ch, 0, numSamples);
+        }
+        
+        const juce::int64 numSourceSamples = sampleSource->getLengthInSamples();
         
-        if (sampleBuffer && sampleBuffer->getNumSamples() > 0)
+        if (numSourceSamples > 1)
         {
-            int numChannels = outputBuffer.getNumChannels();
-            int numSamples = outputBuffer.getNumSamples();
-            int numSourceSamples = sampleBuffer->getNumSamples();
 
             // mixing dry signal according to the pitch
             for (int ch = 0; ch < numChannels; ++ch)
             {
-                float& readHead = dryReadHeads[ch % dryReadHeads.size()];
+                double& readHead = dryReadHeads[(size_t) (ch % numDryReadHeads)];
+                int sourceChannel = ch % sourceReaders[0].numChannels;
 
                 for (int i = 0; i < numSamples; ++i)
                 {
-                    int lowerIndex = static_cast<int>(readHead);
-                    int upperIndex = juce::jmin(lowerIndex + 1, numSourceSamples - 1);  // prevent wrap discontinuity
-                    float frac = readHead - float(lowerIndex);
+                    juce::int64 lowerIndex = static_cast<juce::int64>(readHead);
+                    juce::int64 upperIndex = juce::jmin(lowerIndex + 1, numSourceSamples - 1);  // prevent wrap discontinuity
+                    float frac = float(readHead - double(lowerIndex));
 
-                    float sampleLower = sampleBuffer->getSample(ch % sampleBuffer->getNumChannels(), lowerIndex);
-                    float sampleUpper = sampleBuffer->getSample(ch % sampleBuffer->getNumChannels(), upperIndex);
+                    float sampleLower = sourceReaders[0].sample(sourceChannel, lowerIndex);
+                    float sampleUpper = sourceReaders[0].sample(sourceChannel, upperIndex);
 
                     float interpolatedSample = sampleLower * (1.0f - frac) + sampleUpper * frac;
                     dryBuffer.setSample(ch, i, interpolatedSample);
 
                     readHead += playbackRate;
-                    if (readHead >= numSourceSamples - 1)
-                        readHead -= (numSourceSamples - 1); // wrap just before last sample to avoid read beyond buffer
+                    if (readHead >= double(numSourceSamples - 1))
+                        readHead -= double(numSourceSamples - 1); // wrap just before last sample to avoid read beyond buffer
                 }
             }
         }
         
-        //==================================== Quantise =======================================================
-
-        if (*quantiseParam > 0.5f) // quantise ON
-        {
-            double msPerQuarter = (60.0 / currentBpm) * 1000.0;
-
-            // --- Choose a rhythmic subdivision ---
-            int division = 1; // 1 = quarter, 2 = 8th, 4 = 16th, 6 = 16th triplet, etc.
+        // ================================================
 
-            switch (static_cast<int>(*quantiseDivisionParam))
-            {
-                case 0: division = 1; break;  // quarter
-                case 1: division = 2; break;  // eighth
-                case 2: division = 4; break;  // sixteenth
-                default: division = 2; break;
-            }
+        const int endSample = startSample + numSamples;
+        // grains this voice keeps alive on average; over its share of the budget, they are spawned further apart instead
+        predictedGrains = params.lengthSamples / params.spawnInterval;
+        const double interval = params.spawnInterval * juce::jmax (1.0, predictedGrains / grainBudget);
+        const int mode = params.mode;
 
-            double msBetweenGrains = msPerQuarter / division;
-            density = msToSamples(msBetweenGrains);
-        }
-        else // quantise OFF
+        // smoothed values move once per control tick, and in a straight line between ticks
+        for (int tickStart = startSample; tickStart < endSample; tickStart += controlInterval)
         {
-            density = msToSamples(*densityParam); // freeform mode
-        }
+            const int tickLength = juce::jmin (controlInterval, endSample - tickStart);
+            smoothSparse.advance (params.sparse, tickLength);
+            smoothedFeedback.advance (params.feedback, tickLength);
 
-        // ================================================
-
-        for (int i = startSample; i < startSample + numSamples; ++i)
-        {
-            // determine envelope value
-            float enVal = envelope.getNextSample();
-            int mode = static_cast<int>(*modeParam);
-            smoothSparse.setTargetValue (*sparseParam);
-            float sparse = smoothSparse.getNextValue();
-
-            // Spawn grain every N samples (e.g. based on a density param or interval)
-            if (currentSampleIndex % density == 0)
+            for (int offset = 0; offset < tickLength;)
             {
-                float level = *levelParam * enVal;
-
-                // set the rate and playback method
-                float rate = playbackRate;
-                grainPosition = *positionParam; //0.2f + (static_cast<float>(rand()) / RAND_MAX) * 0.6f;
-                
-                int playbackMode = static_cast<int>(*playbackParam);
-                float grainRate = rate;
-                
-                if (playbackMode == 0)
-                {
-                    grainRate = rate;
-                }
-                else if (playbackMode == 1)
-                {
-                    grainRate = -(rate);
-                }
-                else
-                {
-                    bool flip =( rand() % 2 == 0);
-                    if (flip)
-                    {
-                        grainRate = rate;
-                    }
-                    else
-                    {
-                        grainRate = -(rate);
-                    }
-                }
-                
-                // deviation from the position
-                float deviation = (juce::Random::getSystemRandom().nextFloat() * 2.0f - 1.0f); // -1 to +1
-                float spreadAmount = sparse * 0.5f;  // max spread = ±0.5
-
-                float position = juce::jlimit(0.0f, 1.0f, grainPosition + (deviation * spreadAmount));
-                float spread = *spreadParam;
-                
-                // setting the length and the randomness jitter around it
-                int baseLength = msToSamples(*lengthParam);
-                float jitterAmount = *jitterParam; // 0.0 to 1.0
-                float randVal = ((rand() / static_cast<float>(RAND_MAX)) * 2.0f - 1.0f); // -1 to +1
-                int jitterSamples = static_cast<int>(baseLength * jitterAmount * randVal);
-                int length = std::max(1, baseLength + jitterSamples); // keep length at least 1
-                
-                // skip a few grains on generation by choosing probability levels
-                float levelRandomness = *probParam;
-                if (levelRandomness > 0.0f)
+                int spanStart = offset;
+
+                // determine envelope value, then spawn every grain due on this sample - a cloud can have several.
+                // Delay grains start behind the write head, which has taken every sample before this one by now
+                if (scheduler.getNextOnsetSample (interval) <= currentSampleIndex)
                 {
-                    float randProb = rand()/float(RAND_MAX);
-                    
-                    if (randProb > levelRandomness)
+                    const float enVal = envelope.getNextSample();
+
+                    while (scheduler.getNextOnsetSample (interval) <= currentSampleIndex)
                     {
-                        level = 0.0f;
+                        spawnGrain (scheduler.getNextOnset (interval), enVal, smoothSparse.at (offset), numSourceSamples);
+                        scheduler.advance (interval, params.scheduling, random);
                     }
+
+                    ++spanStart;
                 }
-                
-                // set the onset
-                int onset = i + currentSampleIndex;
-                
-                // choose the mode: Delay process
-                if (mode == 0)
-                {
-                    int delayOffset = (delayLine.getWriteHeadPosition() - int(position * delayLine.getDelaySize()) + delayLine.getDelaySize()) % delayLine.getDelaySize();
-                    grains.add (Grain (onset, length, grainRate, level,0, delayOffset, getSampleRate(), spread));
-                }
-                // choose the mode: Sample process
-                else
-                {
-                    grains.add (Grain (onset, length, grainRate, level, position, 0, getSampleRate(), spread));
-                }
-                
-                // smooth out the release of the ADSR
-                if (!envelope.isActive())
-                {
-                    noteOn = false;
-                    clearCurrentNote();
-                }
-            }
-            
-            // Setting envelope
-            int envelope = static_cast<int>(*envelopeParam);
-            // setting number of grains - helps with layering
-            int activity = (static_cast<int>(*activityParam))*activeVoiceOn;
-            
-            //delayline input
-            float input = sampleBuffer -> getSample(0, currentSampleIndex % sampleBuffer -> getNumSamples());
-            //delayLine.setInputSample(input);
-            delayLine.process (input);
-            
-            float grainSum=0.0f;
-            // process grains back into the delay line =======================================================================
-            for (int g = grains.size() - 1; g >=0; --g)
-            {
-                // Delay Granular
-                if (mode == 0)
-                {
-                    grains[g].delayProcess (outputBuffer, delayLine, currentSampleIndex, i, envelope, activity);
-                    
-                    // Manual re-render for feeding — same calculation as inside delayProcess
-                    int t = currentSampleIndex - grains[g].getOnset();
-                    if (t >= 0 && t < grains[g].getLength())
-                    {
-                        float readPos = grains[g].getDelayOffset() + t * grains[g].getRate();
-                        while (readPos < 0) readPos += delayLine.getDelaySize();
-                        while (readPos >= delayLine.getDelaySize()) readPos -= delayLine.getDelaySize();
 
-                        int lower = floor(readPos);
-                        int upper = (lower + 1) % delayLine.getDelaySize();
-                        float frac = readPos - lower;
+                // the samples up to the next grain onset are run straight through, nothing is tested on them,
+                // and go into the delay line in one run along with the onset
+                const int spanEnd = juce::jlimit (spanStart, tickLength, offset + scheduler.getNextOnsetSample (interval) - currentSampleIndex);
 
-                        float lowerVal = delayLine.getSampleAtIndex(lower);
-                        float upperVal = delayLine.getSampleAtIndex(upper);
-                        float sample = (1.0f - frac) * lowerVal + frac * upperVal;
+                for (int i = spanStart; i < spanEnd; ++i)
+                    envelope.getNextSample();
 
-                        float env = grains[g].triEnvelope(t); // or select based on type
-                        float levelSmoothed = grains[g].getSmoothedLevel();
-                        float gain = levelSmoothed / std::max(1, activity);
+                processDelayInput (tickStart - startSample, offset, spanEnd, numSourceSamples);
+                offset = spanEnd;
+            }
+        }
+        
+        // render grains ==========================================================================================
+        
+        // Setting envelope
+        const float* envTable = envelopeTables->getTable(params.envelopeShape);
+        // setting number of grains - helps with layering
+        int activity = params.activity * activeVoiceOn;
+        float grainGain = 1.0f / juce::jmax(1, activity);
+        int quality = params.quality;
+        int blockStart = currentSampleIndex - numSamples;
+        
+        // anything still over the budget (a burst of a cloud, a budget that just shrank) fades out, quietest first
+        grains.cull (grainBudget, currentSampleIndex, blockStart, cullFadeLength, envTable);
+        
+        std::fill (feedbackBuffer.begin(), feedbackBuffer.end(), 0.0f);
+        
+        // Delay Granular - the feedback is rendered alongside, and fed back next block
+        if (mode == 0)
+        {
+            grains.renderBlock (wetBuffer, feedbackBuffer.data(), delayLine, blockStart, numSamples, envTable, grainGain, quality);
+        }
+        // Normal Sample
+        else
+        {
+            // grains spawned before a sample change finish on the source they started on
+            if (retiringSource != nullptr)
+                grains.renderBlock (wetBuffer, retiringReaders.data(), blockStart, numSamples, envTable, grainGain, quality, 1 - sourceSlot);
+            
+            grains.renderBlock (wetBuffer, sourceReaders.data(), blockStart, numSamples, envTable, grainGain, quality,
+                                retiringSource != nullptr ? sourceSlot : GrainPool::allSlots);
+        }
+        
+        // the finished grains get erased out
+        if (reportGrains)
+            grains.removeFinished (currentSampleIndex, [this] (uint32_t id) { reportRetire (id); });
+        else
+            grains.removeFinished (currentSampleIndex);
+        
+        // mix of dry and granulated output ==========================================================
+        for (int tickStart = 0; tickStart < numSamples; tickStart += controlInterval)
+        {
+            const int tickLength = juce::jmin (controlInterval, numSamples - tickStart);
+            smoothedMix.advance (params.mix, tickLength);
 
-                        grainSum += sample * env * gain;
-                    }
-                }
-                // Normal Sample
-                else
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const float* dry = dryBuffer.getReadPointer (ch, tickStart);
+                const float* wet = wetBuffer.getReadPointer (ch, tickStart);
+                float* out = outputBuffer.getWritePointer (ch, startSample + tickStart);
+
+                for (int offset = 0; offset < tickLength; ++offset)
                 {
-                    grains[g].sampleProcess (outputBuffer, *sampleBuffer, currentSampleIndex, i, envelope, activity);
+                    float wetMix = smoothedMix.at (offset);
+                    float dryMix = 1.0f - wetMix;
+
+                    float mixed = dry[offset] * dryMix + wet[offset] * wetMix;
+                    //limiter
+                    mixed = juce::jlimit(-1.0f, 1.0f, mixed);
+                    
+                    out[offset] += mixed;
                 }
-                
-                // the grain gets erased out 
-                if (grains[g].isDone(currentSampleIndex)) grains.remove(g);
-               
             }
-            
-            // parameters that control the feedback amount and the grain feedback amount
-            float feedbackGain = 0.0f;
-            smoothedFeedback.setTargetValue (*feedbackParam);
-            float feedbackAmt = smoothedFeedback.getNextValue();
-            delayLine.setFeedback(feedbackAmt);
-            if (grainFeedbackParam != nullptr)
-                feedbackGain = *grainFeedbackParam;
-            //delayLine.setInputSample(grainSum * feedbackGain);
-            delayLine.process(grainSum * feedbackGain);
-            
-            // global timer
-            currentSampleIndex += 1; // global counter
         }
+    }
+    
+    /**
+     draws one grain's random settings and adds it to the pool
+     
+     @param exactOnset double - voice time the scheduler placed the grain at, up to a sample before currentSampleIndex
+     @param enVal float - note envelope at the onset
+     @param sparse float - smoothed position spread
+     @param numSourceSamples juce::int64
+     */
+    void spawnGrain (double exactOnset, float enVal, float sparse, juce::int64 numSourceSamples)
+    {
+        float level = params.level * enVal;
+
+        // set the rate and playback method
+        float rate = playbackRate;
+        grainPosition = params.position; //0.2f + (static_cast<float>(rand()) / RAND_MAX) * 0.6f;
         
-        // mix of dry and granulated output ==========================================================
-        smoothedMix.setTargetValue (*mixParam);
+        int playbackMode = params.playbackMode;
+        float grainRate = rate;
+        
+        // every grain takes the same draws in the same order, so a seed always replays the same cloud
+        bool flip = random.nextUnit() < 0.5f;
+        float deviation = random.nextBipolar(); // -1 to +1
+        float randVal = random.nextBipolar(); // -1 to +1
+        float randProb = random.nextUnit();
+        float pan = random.nextBipolar() * params.spread;
+        
+        if (playbackMode == 0)
+        {
+            grainRate = rate;
+        }
+        else if (playbackMode == 1)
+        {
+            grainRate = -(rate);
+        }
+        else
+        {
+            if (flip)
+            {
+                grainRate = rate;
+            }
+            else
+            {
+                grainRate = -(rate);
+            }
+        }
+        
+        // deviation from the position
+        float spreadAmount = sparse * 0.5f;  // max spread = ±0.5
 
-        for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
+        float position = juce::jlimit(0.0f, 1.0f, grainPosition + (deviation * spreadAmount));
+        
+        // setting the length and the randomness jitter around it
+        int baseLength = params.lengthSamples;
+        float jitterAmount = params.jitter; // 0.0 to 1.0
+        int jitterSamples = static_cast<int>(baseLength * jitterAmount * randVal);
+        int length = std::max(1, baseLength + jitterSamples); // keep length at least 1
+        
+        // skip a few grains on generation by choosing probability levels
+        float levelRandomness = params.levelRandomness;
+        if (levelRandomness > 0.0f)
         {
-            for (int i = startSample; i < startSample + numSamples; ++i)
+            if (randProb > levelRandomness)
             {
-                float wetMix = smoothedMix.getNextValue();
-                float dryMix = 1.0f - wetMix;
-                
-                float dry = dryBuffer.getSample (ch, i);
-                float wet = outputBuffer.getSample (ch, i);
-
-                float mixed = dry * dryMix + wet * wetMix;
-                //limiter
-                mixed = juce::jlimit(-1.0f, 1.0f, mixed);
-                
-                outputBuffer.setSample (ch, i, mixed);
+                level = 0.0f;
             }
         }
         
+        // smooth out the release of the ADSR
+        if (!envelope.isActive())
+        {
+            noteOn = false;
+            clearCurrentNote();
+            
+            if (reportGrains)
+                reportClear();
+        }
+        
+        // a silent grain would cost as much to render as any other, so it is never added
+        if (level <= 0.0f)
+            return;
         
+        // set the onset - the grain starts on this sample, its read position moves on by the part of a sample it started late
+        int onset = currentSampleIndex;
+        double lateBy = double (onset) - exactOnset;
+        
+        // choose the mode: Delay process
+        if (params.mode == 0)
+        {
+            int delayOffset = delayLine.getIndexBehindWriteHead (int(position * delayLine.getDelaySize()));
+            bool added = grains.add (Grain (onset, length, grainRate, level,0, delayOffset, getSampleRate(), pan), double (delayOffset) + lateBy * grainRate, sourceSlot);
+            
+            // the write head moves on by one sample per sample, so the distance behind it changes by 1 - rate
+            if (added && reportGrains)
+                reportSpawn (position, (1.0f - grainRate) * float (length) / float (delayLine.getDelaySize()), length, pan, level);
+        }
+        // choose the mode: Sample process - faster grains read a decimated copy of the sample
+        else
+        {
+            int sampleLevel = 0;
+            float levelBlend = 0.0f;
+            sampleSource->getLevelFor (grainRate, sampleLevel, levelBlend);
+            bool added = grains.add (Grain (onset, length, grainRate, level, position, 0, getSampleRate(), pan), std::floor (double (position) * double (numSourceSamples)) + lateBy * grainRate, sourceSlot, sampleLevel, levelBlend);
+            
+            if (added && reportGrains)
+                reportSpawn (position, grainRate * float (length) / float (numSourceSamples), length, pan, level);
+        }
     }
     
     /**
-     Sets the pointer to the sample buffer from which grains will be generated
+     tells the editor about the grain just added - only while it is open
      
-     @param buffer juce::AudioBuffer<float>*
+     @param position float - start, 0-1 of the source or of the delay line
+     @param span float - distance the read head covers, same units
+     @param length int - samples
+     @param pan float
+     @param level float
      */
-    void setSampleBuffer (juce::AudioBuffer<float>* buffer)
+    void reportSpawn (float position, float span, int length, float pan, float level)
     {
-        sampleBuffer = buffer;
+        GrainEvent event;
+        event.type = GrainEvent::spawn;
+        event.mode = (uint8_t) params.mode;
+        event.voice = (uint16_t) voiceIndex;
+        event.id = grains.getLastAddedId();
+        event.position = position;
+        event.span = span;
+        event.duration = float (length / getSampleRate());
+        event.pan = pan;
+        event.level = level;
+        grainEvents.push (event);
     }
     
-    /**
-     MIDI pitch wheel handler
-     */
-    void pitchWheelMoved (int) override
-    {}
+    void reportRetire (uint32_t id)
+    {
+        GrainEvent event;
+        event.type = GrainEvent::retire;
+        event.voice = (uint16_t) voiceIndex;
+        event.id = id;
+        grainEvents.push (event);
+    }
+    
+    void reportClear()
+    {
+        GrainEvent event;
+        event.type = GrainEvent::clear;
+        event.voice = (uint16_t) voiceIndex;
+        grainEvents.push (event);
+    }
     
     /**
-     MIDI controller handler
-     */
-    void controllerMoved (int, int) override
-    {}
-
-    /**
-     convert milliseconds to samples, given the current sample rate
+     feeds a run of the source, plus the grain feedback of the previous block, into the delay line and moves voice time on.
+     The run stays inside one control tick, so it is far shorter than the delay and the line can take it in one go.
      
-     @param ms float
+     @param tickIndex int - sample of the block the control tick starts on, 0 is startSample
+     @param begin int - first sample of the run, 0 is the start of the tick
+     @param end int - one past the last sample of the run
+     @param numSourceSamples juce::int64
      */
-    int msToSamples(float ms)
+    void processDelayInput (int tickIndex, int begin, int end, juce::int64 numSourceSamples)
     {
-        return int((ms / 1000.0f) * getSampleRate());
+        const int numFrames = end - begin;
+        float left[controlInterval], right[controlInterval], feedback[controlInterval];
+        
+        //delayline input - both channels of the source (a mono source fills both sides), wrapping at its end
+        for (int done = 0; done < numFrames;)
+        {
+            const juce::int64 inputIndex = (currentSampleIndex + done) % numSourceSamples;
+            const int count = (int) juce::jmin ((juce::int64) (numFrames - done), numSourceSamples - inputIndex);
+            sourceReaders[0].read (inputIndex, left + done, right + done, count);
+            done += count;
+        }
+        
+        // plus the grain feedback rendered during the previous block in the middle, and the smoothed delay feedback
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const float grainFeedback = feedbackBuffer[(size_t) (tickIndex + begin + i)] * params.grainFeedback;
+            left[i] += grainFeedback;
+            right[i] += grainFeedback;
+            feedback[i] = smoothedFeedback.at (begin + i);
+        }
+        
+        const float* input[2] = { left, right };
+        delayLine.process (input, feedback, numFrames);
+        
+        // global timer
+        currentSampleIndex += numFrames; // global counter
     }
-
-
-private:
+    
     // Internal State
     bool noteOn = false;
     float grainPosition = 0.0f;
     float gain = 1.0f;
     int currentSampleIndex = 0;
-    int activeVoiceOn;
+    int activeVoiceOn = 0;
     float playbackRate = 1.0f;
-    int density;
     
     // Audio data
-    juce::AudioBuffer<float>* sampleBuffer = nullptr;
-    std::vector<float> dryReadHeads;
+    GrainSampleSource::Ptr sampleSource;
+    std::array<GrainSampleSource::Reader, GrainSampleSource::maxLevels> sourceReaders; // one per pyramid level
+    GrainSampleSource::Ptr retiringSource; // the previous source, while grains spawned from it are still playing
+    std::array<GrainSampleSource::Reader, GrainSampleSource::maxLevels> retiringReaders;
+    int sourceSlot = 0;                    // GrainPool slot of grains spawned from sampleSource, the retiring ones use the other
+    std::array<double, 2> dryReadHeads {};
+    int numDryReadHeads = 1;
+    const GrainEnvelopeTables* envelopeTables = nullptr;
     double currentBpm = 120.0;
     
     // Grain management
-    juce::Array<Grain> grains;
+    GrainPool grains;
+    GrainRandom random;
+    GrainScheduler scheduler;
+    uint32_t voiceIndex = 0;
+    uint32_t noteCount = 0;
+    juce::AudioBuffer<float> dryBuffer;
+    juce::AudioBuffer<float> wetBuffer;
+    std::vector<float> feedbackBuffer;
     // Tapped-Delay Line
     DelayLine delayLine;
     int maxDelaySize = 0;
     
+    // Grain spawns and retires for the editor, only pushed while it is open
+    GrainEventQueue grainEvents;
+    bool reportGrains = false; // grainEvents.isEnabled(), read once per block
+    
+    // Grain budget
+    int grainBudget = std::numeric_limits<int>::max();
+    int cullFadeLength = 1;
+    double predictedGrains = 0.0;
+    
     // ADSR and smoothing
     juce::ADSR envelope;
-    juce::SmoothedValue<float> smoothSparse;
-    juce::SmoothedValue<float> smoothedMix;
-    juce::SmoothedValue<float> smoothedFeedback;
-
-    // Parameters
-    std::atomic<float>* levelParam;
-    std::atomic<float>* positionParam;
-    std::atomic<float>* spreadParam;
-    std::atomic<float>* envelopeParam;
-    std::atomic<float>* activityParam;
-    std::atomic<float>* sparseParam;
-    std::atomic<float>* jitterParam;
-    std::atomic<float>* lengthParam;
-    std::atomic<float>* probParam;
-    std::atomic<float>* modeParam;
-    std::atomic<float>* densityParam;
-    std::atomic<float>* mixParam;
-    std::atomic<float>* playbackParam;
-    std::atomic<float>* quantiseParam;
-    std::atomic<float>* quantiseDivisionParam;
-    std::atomic<float>* grainFeedbackParam;
-    std::atomic<float>* feedbackParam;
+    ControlRamp smoothSparse;
+    ControlRamp smoothedMix;
+    ControlRamp smoothedFeedback;
+
+    // Parameters, read once per block
+    GrainParameters params;
+    static constexpr int controlInterval = 32; // samples per control tick of the smoothed values
 };
 
+// ==================================================== Grain Synthesiser =================================================================================
+
+/**
+ Synthesiser that can render its active voices in parallel on a VoiceWorkerPool.
+ 
+ Each voice renders into its own preallocated buffer and the buffers are then summed in voice order,
+ which gives exactly the same result as rendering the voices one after another. Blocks that are too
+ small to be worth handing over, or bigger than the buffers prepared for, are rendered serially.
+ */
+class GrainSynthesiser : public juce::Synthesiser
+{
+public:
+    /**
+     prepares the voice buffers and starts the worker threads - called from prepareToPlay after the voices are added
+     
+     @param sampleRate double
+     @param samplesPerBlock int
+     @param numChannels int
+     */
+    void prepare (double sampleRate, int samplesPerBlock, int numChannels)
+    {
+        voiceBuffers.clear();
+        for (int i = 0; i < getNumVoices(); ++i)
+            voiceBuffers.add (new juce::AudioBuffer<float> (numChannels, samplesPerBlock));
+        
+        activeVoices.resize ((size_t) getNumVoices());
+        maxBlockSize = samplesPerBlock;
+        
+        // one worker per extra voice, leaving a core for the host
+        int numWorkers = juce::jmin (getNumVoices() - 1, juce::SystemStats::getNumCpus() - 2);
+        workerPool.start (juce::jmax (0, numWorkers), samplesPerBlock, sampleRate);
+    }
+    
+    void release()
+    {
+        workerPool.stop();
+    }
+    
+    /**
+     switches parallel rendering on or off - safe to call every block
+     
+     @param shouldRenderInParallel bool
+     */
+    void setParallelRendering (bool shouldRenderInParallel)
+    {
+        parallel = shouldRenderInParallel;
+    }
+    
+protected:
+    /**
+     picks the voice to steal when every voice is busy. juce::Synthesiser builds a temporary
+     array of candidates on each steal, this walks the voices instead so a note-on never allocates:
+     the oldest released voice goes first, then the oldest voice that is still held.
+     */
+    juce::SynthesiserVoice* findVoiceToSteal (juce::SynthesiserSound* soundToPlay, int midiChannel, int midiNoteNumber) const override
+    {
+        juce::SynthesiserVoice* oldestReleased = nullptr;
+        juce::SynthesiserVoice* oldestHeld = nullptr;
+        
+        for (auto* voice : voices)
+        {
+            if (! voice->canPlaySound (soundToPlay))
+                continue;
+            
+            auto*& oldest = (voice->isKeyDown() || voice->isSustainPedalDown()) ? oldestHeld : oldestReleased;
+            
+            if (oldest == nullptr || voice->wasStartedBefore (*oldest))
+                oldest = voice;
+        }
+        
+        return oldestReleased != nullptr ? oldestReleased : oldestHeld;
+    }
+    
+    using juce::Synthesiser::renderVoices;
+    
+    void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override
+    {
+        numActiveVoices = 0;
+        if (parallel && workerPool.getNumWorkers() > 0 && numSamples >= minParallelBlockSize && numSamples <= maxBlockSize)
+            for (int i = 0; i < voices.size() && i < voiceBuffers.size(); ++i)
+                if (voices.getUnchecked (i)->isVoiceActive())
+                    activeVoices[(size_t) numActiveVoices++] = i;
+        
+        if (numActiveVoices < 2)
+        {
+            juce::Synthesiser::renderVoices (outputAudio, startSample, numSamples);
+            return;
+        }
+        
+        blockSize = numSamples;
+        workerPool.run (renderVoiceJob, this, numActiveVoices);
+        
+        // summed in voice order, so the result doesn't depend on which thread finished first
+        for (int v = 0; v < numActiveVoices; ++v)
+        {
+            auto& voiceBuffer = *voiceBuffers.getUnchecked (activeVoices[(size_t) v]);
+            for (int ch = 0; ch < outputAudio.getNumChannels(); ++ch)
+                outputAudio.addFrom (ch, startSample, voiceBuffer, ch % voiceBuffer.getNumChannels(), 0, numSamples);
+        }
+    }
+    
+private:
+    static void renderVoiceJob (void* context, int job)
+    {
+        auto& synth = *static_cast<GrainSynthesiser*> (context);
+        const int index = synth.activeVoices[(size_t) job];
+        auto& voiceBuffer = *synth.voiceBuffers.getUnchecked (index);
+        
+        for (int ch = 0; ch < voiceBuffer.getNumChannels(); ++ch)
+            voiceBuffer.clear (ch, 0, synth.blockSize);
+        
+        synth.voices.getUnchecked (index)->renderNextBlock (voiceBuffer, 0, synth.blockSize);
+    }
+    
+    // below this many samples the hand-over costs more than the voices (e.g. blocks split by MIDI events)
+    static constexpr int minParallelBlockSize = 32;
+    
+    VoiceWorkerPool workerPool;
+    juce::OwnedArray<juce::AudioBuffer<float>> voiceBuffers;
+    std::vector<int> activeVoices;
+    int numActiveVoices = 0;
+    int blockSize = 0;
+    int maxBlockSize = 0;
+    bool parallel = false;
+};
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    GrainScheduler.h
+    Created: 19 Oct 2026 2:36:18pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainScheduler - when the grains of one voice start
+
+ Keeps the exact (fractional) voice time of the next grain onset, so the voice can run
+ straight through the samples up to it without testing each one. Onsets accumulate in double
+ precision, so an interval that isn't a whole number of samples (e.g. a tempo-synced one)
+ never drifts.
+
+ Periodic timing spaces grains exactly one interval apart; cloud timing draws each gap from an
+ exponential distribution with the interval as its mean, which makes the onsets a Poisson process
+ (asynchronous granular synthesis). Each voice starts at its own phase inside the first interval,
+ so voices of a chord don't all spawn on the same sample.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+#include "GrainRandom.h"
+
+class GrainScheduler
+{
+public:
+    // Matches the order of the "Scheduling" choice parameter
+    enum Mode
+    {
+        periodic = 0,
+        cloud
+    };
+
+    /**
+     starts a new note - the first onset is placed once the interval is known
+     @param startTime double - voice time of the note start
+     @param phase double - 0 to 1, where in the first interval the first grain falls
+     */
+    void reset (double startTime, double phase)
+    {
+        noteStart = startTime;
+        startPhase = phase;
+        firstPending = true;
+    }
+
+    /**
+     Returns the voice time of the next onset
+     @param interval double - samples between grains (their mean in cloud timing)
+     */
+    double getNextOnset (double interval)
+    {
+        if (firstPending)
+        {
+            nextOnset = noteStart + startPhase * interval;
+            firstPending = false;
+        }
+
+        return nextOnset;
+    }
+
+    /**
+     Returns the first whole sample at or after the next onset
+     @param interval double
+     */
+    int getNextOnsetSample (double interval)
+    {
+        return (int) std::ceil (getNextOnset (interval));
+    }
+
+    /**
+     moves on to the onset after the current one
+     @param interval double - samples between grains (their mean in cloud timing)
+     @param mode int - GrainScheduler::Mode
+     @param random GrainRandom& - only drawn from in cloud timing, so periodic clouds replay as before
+     */
+    void advance (double interval, int mode, GrainRandom& random)
+    {
+        if (mode == cloud)
+            interval *= -std::log (1.0 - (double) random.nextUnit());
+
+        nextOnset += interval;
+    }
+
+private:
+    double nextOnset = 0.0;
+    double noteStart = 0.0;
+    double startPhase = 0.0;
+    bool firstPending = true;
+};
@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    Interpolation.h
+    Created: 17 Oct 2026 4:51:08pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @struct GrainInterpolation - fractional-position readers shared by the Sample and Delay modes
+
+ Every interpolator works on one SIMD register of read positions at a time - consecutive samples
+ of one grain. The grain kernel gathers numTaps source samples per lane around
+ floor (position + positionOffset), starting at firstTap, into one row per tap, and interpolate()
+ combines the rows for all lanes at once.
+ The qualities trade CPU for aliasing:
+    nearest - 1 tap, the cheapest, audible stepping at any rate other than 1
+    linear  - 2 taps
+    cubic   - 4-point 3rd-order Hermite
+    sinc    - 8-tap windowed sinc from a precomputed polyphase table
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+struct GrainInterpolation
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+
+    // Matches the order of the "Interpolation" choice parameter
+    enum Quality
+    {
+        nearest = 0,
+        linear,
+        cubic,
+        sinc,
+        numQualities
+    };
+
+    //==============================================================================
+    struct Nearest
+    {
+        static constexpr int numTaps = 1;
+        static constexpr int firstTap = 0;
+        static constexpr float positionOffset = 0.5f; // rounds instead of truncating
+
+        static Vec interpolate (const float (*taps)[lanes], const float*)
+        {
+            return Vec::fromRawArray (taps[0]);
+        }
+    };
+
+    struct Linear
+    {
+        static constexpr int numTaps = 2;
+        static constexpr int firstTap = 0;
+        static constexpr float positionOffset = 0.0f;
+
+        static Vec interpolate (const float (*taps)[lanes], const float* frac)
+        {
+            const auto x0 = Vec::fromRawArray (taps[0]);
+            return x0 + Vec::fromRawArray (frac) * (Vec::fromRawArray (taps[1]) - x0);
+        }
+    };
+
+    struct Cubic
+    {
+        static constexpr int numTaps = 4;
+        static constexpr int firstTap = -1;
+        static constexpr float positionOffset = 0.0f;
+
+        static Vec interpolate (const float (*taps)[lanes], const float* frac)
+        {
+            const auto xm1 = Vec::fromRawArray (taps[0]);
+            const auto x0  = Vec::fromRawArray (taps[1]);
+            const auto x1  = Vec::fromRawArray (taps[2]);
+            const auto x2  = Vec::fromRawArray (taps[3]);
+            const auto f   = Vec::fromRawArray (frac);
+
+            const auto c1 = (x1 - xm1) * 0.5f;
+            const auto c2 = xm1 - x0 * 2.5f + x1 * 2.0f - x2 * 0.5f;
+            const auto c3 = (x2 - xm1) * 0.5f + (x0 - x1) * 1.5f;
+            return ((c3 * f + c2) * f + c1) * f + x0;
+        }
+    };
+
+    struct Sinc
+    {
+        static constexpr int numTaps = 8;
+        static constexpr int firstTap = -(numTaps / 2 - 1);
+        static constexpr float positionOffset = 0.0f;
+        static constexpr int numPhases = 512;
+
+        /**
+         one row of numTaps coefficients per fractional phase, plus a guard row for phase 1.0.
+         Built once, on first use - prepareToPlay touches it so the audio thread never does.
+         */
+        struct Table
+        {
+            Table()
+            {
+                // cut off at Nyquist, so phase 0 passes the source through untouched like the other qualities
+                const double halfWidth = numTaps / 2;
+
+                for (int phase = 0; phase <= numPhases; ++phase)
+                {
+                    const double frac = double (phase) / numPhases;
+                    double sum = 0.0;
+
+                    for (int k = 0; k < numTaps; ++k)
+                    {
+                        const double x = double (k + firstTap) - frac;
+                        const double arg = juce::MathConstants<double>::pi * x;
+                        const double sincValue = std::abs (x) < 1.0e-9 ? 1.0 : std::sin (arg) / arg;
+
+                        // Blackman window over the kernel span
+                        const double w = juce::jlimit (0.0, 1.0, (x + halfWidth) / (2.0 * halfWidth));
+                        const double window = 0.42 - 0.5 * std::cos (2.0 * juce::MathConstants<double>::pi * w)
+                                                    + 0.08 * std::cos (4.0 * juce::MathConstants<double>::pi * w);
+
+                        coefficients[(size_t) (phase * numTaps + k)] = float (sincValue * window);
+                        sum += sincValue * window;
+                    }
+
+                    // unity gain at DC for every phase
+                    for (int k = 0; k < numTaps; ++k)
+                        coefficients[(size_t) (phase * numTaps + k)] = float (coefficients[(size_t) (phase * numTaps + k)] / sum);
+                }
+            }
+
+            std::array<float, (numPhases + 1) * numTaps> coefficients {};
+        };
+
+        static const Table& getTable()
+        {
+            static const Table table;
+            return table;
+        }
+
+        static Vec interpolate (const float (*taps)[lanes], const float* frac)
+        {
+            const float* coefficients = getTable().coefficients.data();
+            alignas (Vec::SIMDRegisterSize) float rows[numTaps][lanes];
+
+            // coefficients for each lane's phase, linearly interpolated between neighbouring phases
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                const float phase = frac[lane] * float (numPhases);
+                const int row = juce::jlimit (0, numPhases - 1, int (phase));
+                const float blend = phase - float (row);
+                const float* a = coefficients + row * numTaps;
+                const float* b = a + numTaps;
+
+                for (int k = 0; k < numTaps; ++k)
+                    rows[k][lane] = a[k] + blend * (b[k] - a[k]);
+            }
+
+            auto sum = Vec::fromRawArray (taps[0]) * Vec::fromRawArray (rows[0]);
+            for (int k = 1; k < numTaps; ++k)
+                sum += Vec::fromRawArray (taps[k]) * Vec::fromRawArray (rows[k]);
+
+            return sum;
+        }
+    };
+};
@@ -11,11 +11,17 @@
 
 //==============================================================================
 TryGranulatorAudioProcessorEditor::TryGranulatorAudioProcessorEditor (TryGranulatorAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), cloudView (p), envelopeEditor (p), parameterEditor (p)
 {
+    addAndMakeVisible (cloudView);
+    addAndMakeVisible (envelopeEditor);
+    addAndMakeVisible (parameterEditor);
+    
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setResizable (true, true);
+    setResizeLimits (500, 400, 1600, 1400);
+    setSize (720, 680);
 }
 
 TryGranulatorAudioProcessorEditor::~TryGranulatorAudioProcessorEditor()
@@ -27,15 +33,13 @@ void TryGranulatorAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void TryGranulatorAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto area = getLocalBounds();
+    auto top = area.removeFromTop (juce::jmax (160, area.getHeight() / 3));
+    envelopeEditor.setBounds (top.removeFromRight (juce::jmax (180, top.getWidth() / 4)));
+    cloudView.setBounds (top);
+    parameterEditor.setBounds (area);
 }
-
@@ -10,9 +10,12 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "EnvelopeEditor.h"
+#include "GrainCloudView.h"
 
 //==============================================================================
 /**
+ The grain cloud on top, the custom envelope beside it, the plugin parameters underneath
 */
 class TryGranulatorAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
@@ -28,6 +31,15 @@ private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     TryGranulatorAudioProcessor& audioProcessor;
+    
+    // live grains over the source, fed by the voices' grain event queues
+    GrainCloudView cloudView;
+    
+    // shape of the "Custom" grain envelope
+    EnvelopeEditor envelopeEditor;
+    
+    // every parameter, laid out by JUCE
+    juce::GenericAudioProcessorEditor parameterEditor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TryGranulatorAudioProcessorEditor)
 };
@@ -9,7 +9,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "Grain.h"
-#include "GrainSampler.h"
 
 //==============================================================================
 TryGranulatorAudioProcessor::TryGranulatorAudioProcessor()
@@ -25,20 +24,62 @@ TryGranulatorAudioProcessor::TryGranulatorAudioProcessor()
 #endif
 apvts(*this, nullptr, "TryGranulator", createParameterLayout())
 {
+    // the page warmer follows whichever sample is published
+    pageWarmer.connectParam(apvts);
+    sampleLoader.onPublished = [this] (GrainSampleSource::Ptr source)
+    {
+        pageWarmer.setSource(source);
+        sampleOverview.setSource(source);
+        sampleLoadFailed = false;
+    };
+    sampleLoader.onLoadFailed = [this] (const juce::File&)
+    {
+        sampleLoadFailed = true;
+    };
+    
     // load a sample from the memory
     loadSampleFromMemory();
     
     // retrieving the values of parameters
     reverbMixParam = apvts.getRawParameterValue("ReverbMix");
     reverbOnParam = apvts.getRawParameterValue("ReverbOn");
+    reverbSizeParam = apvts.getRawParameterValue("ReverbSize");
+    reverbDecayParam = apvts.getRawParameterValue("ReverbDecay");
+    reverbDampingParam = apvts.getRawParameterValue("ReverbDamping");
     filterCutoffParam = apvts.getRawParameterValue("FilterCutoff");
     filterTypeParam = apvts.getRawParameterValue("FilterType");
     filterResonanceParam = apvts.getRawParameterValue("FilterResonance");
+    parallelVoicesParam = apvts.getRawParameterValue("ParallelVoices");
+    grainLimitParam = apvts.getRawParameterValue("GrainLimit");
+    
+    // voices are created once - prepareToPlay only sizes the memory they render with
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto* voice = new GrainVoice();
+        voice->setEnvelopeTables(&envelopeTables);
+        voice->setVoiceIndex(i);
+        voice->connectParam(apvts);
+        synth.addVoice(voice);
+    }
+    
+    synth.addSound(new GrainSound());
     
+    // the standalone app can log every block, for sizing machines: TRYGRANULATOR_TELEMETRY=/path/to/log.csv
+    if (wrapperType == wrapperType_Standalone)
+    {
+        auto csvPath = juce::SystemStats::getEnvironmentVariable("TRYGRANULATOR_TELEMETRY", {});
+        if (csvPath.isNotEmpty() && juce::File::isAbsolutePath(csvPath))
+            telemetryMonitor.startCsv(juce::File(csvPath));
+    }
+    
+    telemetryMonitor.start();
 }
 
 TryGranulatorAudioProcessor::~TryGranulatorAudioProcessor()
 {
+    // nothing may be published into the warmer once it has stopped, and the warmer reads parameters, which go before it does
+    sampleLoader.stop();
+    pageWarmer.setSource(nullptr);
 }
 
 //==============================================================================
@@ -76,6 +117,10 @@ bool TryGranulatorAudioProcessor::isMidiEffect() const
 
 double TryGranulatorAudioProcessor::getTailLengthSeconds() const
 {
+    // the reverb rings on for its decay time after the last note - hosts that trust this stop rendering when it is over
+    if (*reverbOnParam > 0.5f)
+        return FdnReverb::getTailSeconds(*reverbDecayParam);
+    
     return 0.0;
 }
 
@@ -106,43 +151,43 @@ void TryGranulatorAudioProcessor::changeProgramName (int index, const juce::Stri
 //==============================================================================
 void TryGranulatorAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    // Grain envelope shapes shared by every voice
+    envelopeTables.build();
+    
+    // the sinc table is built on first use - do it here rather than on the audio thread
+    GrainInterpolation::Sinc::getTable();
+    
     // ============================================================ Synthesiser setup ========================================
-    synth.clearVoices();
-    for (int i = 0; i < 3; ++i) // 3 voices (can increase this, depending on CPU power)
+    
+    // worst case of overlapping grains in one voice: the longest grain (with full jitter) over the shortest spawn interval
+    auto lengthRange = apvts.getParameterRange ("Length");
+    auto densityRange = apvts.getParameterRange ("Density");
+    int maxGrainsPerVoice = (int) std::ceil (lengthRange.end * 2.0f / densityRange.start) + 1;
+    
+    for (int i = 0; i < synth.getNumVoices(); ++i)
     {
-        auto* voice = new GrainVoice();
-        
-        // Attach sample buffer to the voice
-        voice->setSampleBuffer(sampleBuffer.get());
-        synth.addVoice(voice);
-        
-        // Cast voice to GrainVoice and link parameter tree
-        GrainVoice* voicePtr = dynamic_cast<GrainVoice*>(synth.getVoice(i));
-        voicePtr -> connectParam(apvts);
+        if (auto* voice = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+            voice->prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels(), maxGrainsPerVoice);
     }
 
-    synth.clearSounds();
-    synth.addSound(new GrainSound());
-
     synth.setCurrentPlaybackSampleRate(sampleRate);
+    synth.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+    grainBudget.prepare(sampleRate);
+    telemetry.prepare(sampleRate);
     
-    // Reverb reset internal buffers
-    reverb.reset();
-    // Reverb initialisation
-    smoothedReverbMix.reset(getSampleRate(), 0.1);
-    smoothedReverbMix.setCurrentAndTargetValue(*reverbMixParam);
+    // Reverb delay lines, sized for the largest room at this sample rate
+    reverb.prepare(sampleRate, *reverbSizeParam, *reverbMixParam);
+    reverbWasOn = false;
     
-    // Filter configuration (stereo)
-    filterL.setCoefficients(juce::IIRCoefficients::makeLowPass(getSampleRate(), 3000.0));
-    filterR.setCoefficients(juce::IIRCoefficients::makeLowPass(getSampleRate(), 3000.0));
-    filterL.reset();
-    filterR.reset();
+    // Filter configuration (stereo), starting from the current cutoff
+    filter.prepare(sampleRate, *filterCutoffParam);
 }
 
 void TryGranulatorAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    synth.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -186,9 +231,66 @@ void TryGranulatorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 */
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
     buffer.clear(); //clears the output audio buffer before we write anything new into it.
+    
+    // a newly drawn custom envelope, taken once so every voice reads the same table this block
+    envelopeTables.acquireCustomShape();
+    
+    // pick up a newly loaded sample - lock-free, and the one it replaces is freed on the loader thread
+    sampleLoader.acquireLatest(audioSource);
+    
+    // and tell the loader what this instance's voices still read - playing sources first, then retiring ones
+    const GrainSampleSource* heldSources[2 * numVoices] = {};
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+    {
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+        {
+            v->setSampleSource(audioSource);
+            v->getSampleSources(heldSources[i], heldSources[numVoices + i]);
+        }
+    }
+    
+    sampleLoader.setHeld(audioSource.get(), heldSources, 2 * numVoices);
+    
+    // the instance's grain budget is shared out between the voices that can be playing by the end of
+    // the block - the ones already playing plus one for every note-on, as those start theirs inside renderNextBlock
+    grainBudget.setLimit(static_cast<int>(*grainLimitParam));
+    int playingVoices = 0;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (synth.getVoice(i)->isVoiceActive())
+            ++playingVoices;
+    
+    for (const auto metadata : midiMessages)
+        if (metadata.getMessage().isNoteOn())
+            ++playingVoices;
+    
+    playingVoices = juce::jlimit(1, synth.getNumVoices(), playingVoices);
+    const int voiceBudget = grainBudget.getAllowedGrains() / playingVoices;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+            v->setGrainBudget(voiceBudget);
+    
+    synth.setParallelRendering(*parallelVoicesParam > 0.5f);
     synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
     
+    double predictedGrains = 0.0;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+    {
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+        {
+            predictedGrains += v->getPredictedGrains();
+            
+            // the dry signal and the delay input walk through the whole sample - its pages are kept resident ahead of them
+            juce::int64 dryHead, delayInput;
+            v->getSourceReadHeads(dryHead, delayInput);
+            pageWarmer.setReadHead(2 * i, dryHead);
+            pageWarmer.setReadHead(2 * i + 1, delayInput);
+        }
+    }
+    
+    grainBudget.setPredictedGrains(predictedGrains);
+    
     // =================================================== bpm =========================================
     
     double bpm = 120.0;
@@ -198,7 +300,6 @@ void TryGranulatorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
         {
             if (pos->getBpm().hasValue())
                 bpm = *pos->getBpm();
-            DBG("BPM: " << bpm);
         }
     }
 
@@ -213,73 +314,128 @@ void TryGranulatorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     
     // ======================================================= filter =====================================================================
     
-    float cutoff = *filterCutoffParam;
-    float resonance = *filterResonanceParam;
-    int type = static_cast<int>(*filterTypeParam);
-    int sampleRate = getSampleRate();
-
-    juce::IIRCoefficients coeffs;
-
-    if (type == 0)
-        coeffs = juce::IIRCoefficients::makeLowPass(sampleRate, cutoff, resonance);
-    else if (type == 1)
-        coeffs = juce::IIRCoefficients::makeHighPass(sampleRate, cutoff, resonance);
-    else if (type == 2)
-        coeffs = juce::IIRCoefficients::makeBandPass(sampleRate, cutoff, resonance);
-    else
-        coeffs = juce::IIRCoefficients::makeLowPass(sampleRate, cutoff, resonance); // fallback
-
-    filterL.setCoefficients(coeffs);
-    filterR.setCoefficients(coeffs);
-
-    // ===== Apply filter to each sample in buffer ===== // ==================================================
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    // both channels in one register; coefficients only move when the (smoothed) cutoff, the type or the resonance does
+    filter.setParameters(static_cast<int>(*filterTypeParam), *filterCutoffParam, *filterResonanceParam);
+    filter.process(buffer);
+    
+    //==================================================================== Reverb =================================================================
+    
+    const bool reverbOn = *reverbOnParam > 0.5f;
+    if (reverbOn)
     {
-        float left = filterL.processSingleSampleRaw(buffer.getSample(0, i));
-        buffer.setSample(0, i, left);
-
-        if (buffer.getNumChannels() > 1)
+        // switched on: start from an empty room and fade the wet signal in
+        if (! reverbWasOn)
         {
-            float right = filterR.processSingleSampleRaw(buffer.getSample(1, i));
-            buffer.setSample(1, i, right);
+            reverb.reset();
+            reverb.restartMix();
         }
+        
+        // mixed straight into the block, no copy
+        reverb.setParameters(*reverbSizeParam, *reverbDecayParam, *reverbDampingParam, *reverbMixParam);
+        reverb.process(buffer);
     }
+    reverbWasOn = reverbOn;
     
-    //==================================================================== Reverb =================================================================
+    const double renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+    grainBudget.endBlock(renderSeconds, buffer.getNumSamples(), isNonRealtime());
+    recordBlock(renderSeconds, buffer.getNumSamples());
+}
+
+/**
+ pushes the block's render time, voices and grain counts to the telemetry ring - audio thread, after the block is rendered
+ */
+void TryGranulatorAudioProcessor::recordBlock (double renderSeconds, int numSamples)
+{
+    EngineTelemetry::Block block;
+    block.renderSeconds = (float) renderSeconds;
+    block.numVoices = juce::jmin(synth.getNumVoices(), EngineTelemetry::maxVoices);
     
-    if (*reverbOnParam > 0.5f)
+    uint32_t spawned = 0, culled = 0, dropped = 0;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
     {
-        smoothedReverbMix.setTargetValue(*reverbMixParam);
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+        {
+            if (v->isVoiceActive())
+                ++block.activeVoices;
+            
+            if (i < block.numVoices)
+                block.grainsPerVoice[(size_t) i] = (uint16_t) juce::jmin(v->getNumActiveGrains(), 0xffff);
+            
+            spawned += v->getNumSpawnedGrains();
+            culled += v->getNumCulledGrains();
+            dropped += v->getNumDroppedGrains();
+        }
+    }
+    
+    telemetry.pushBlock(block, spawned, culled, dropped, numSamples);
+}
+
+/**
+ total number of grains the voices had to drop because their grain pool was full
+ */
+uint32_t TryGranulatorAudioProcessor::getNumDroppedGrains()
+{
+    uint32_t dropped = 0;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+            dropped += v->getNumDroppedGrains();
+    
+    return dropped;
+}
 
-        // Copy current buffer to a reverb buffer
-        juce::AudioBuffer<float> reverbBuffer;
-        reverbBuffer.makeCopyOf(buffer);
+/**
+ total number of grains faded out early to keep the instance within its grain budget
+ */
+uint32_t TryGranulatorAudioProcessor::getNumCulledGrains()
+{
+    uint32_t culled = 0;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+            culled += v->getNumCulledGrains();
+    
+    return culled;
+}
 
-        // parameters
-        reverbParams.roomSize   = 0.2f;
-        reverbParams.damping    = 0.5f;
-        reverbParams.wetLevel   = *reverbMixParam; // shouldnt the value here be smoothedReverbMix.getNextValue();
-        reverbParams.dryLevel   = 0.0f;
-        reverbParams.width      = 1.0f;
-        reverbParams.freezeMode = 0.0f;
+/**
+ grains the current settings ask for over the grains the budget allows - above 1 the cloud is being thinned. Safe from any thread, e.g. for the editor to warn
+ */
+float TryGranulatorAudioProcessor::getPredictedGrainLoad() const
+{
+    return grainBudget.getPredictedLoad();
+}
 
-        reverb.setParameters(reverbParams);
-        reverb.processStereo(reverbBuffer.getWritePointer(0), reverbBuffer.getWritePointer(1), buffer.getNumSamples());
+/**
+ number of grains alive across all voices - read it from the audio thread, or while the processor is idle
+ */
+int TryGranulatorAudioProcessor::getNumActiveGrains()
+{
+    int active = 0;
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(i)))
+            active += v->getNumActiveGrains();
+    
+    return active;
+}
 
-        // Mix the reverb back in with smoothed mix - Final Output
-        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-        {
-            for (int i = 0; i < buffer.getNumSamples(); ++i)
-            {
-                float mix = smoothedReverbMix.getNextValue();
-                float dry = buffer.getSample(ch, i);
-                float wet = reverbBuffer.getSample(ch, i);
-                float mixed = (1.0f - mix) * dry + mix * wet;
-                buffer.setSample(ch, i, mixed);
-            }
-        }
-    }
+/**
+ the queue a voice reports its grains to, nullptr past the last voice
+ */
+GrainEventQueue* TryGranulatorAudioProcessor::getGrainEvents (int voiceIndex)
+{
+    if (auto* v = dynamic_cast<GrainVoice*>(synth.getVoice(voiceIndex)))
+        return &v->getGrainEvents();
     
+    return nullptr;
+}
+
+/**
+ starts or stops every voice reporting its grains - the editor turns this on while it is open; closed, the voices only check a flag once per block
+ */
+void TryGranulatorAudioProcessor::setGrainEventsEnabled (bool shouldReport)
+{
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (auto* events = getGrainEvents(i))
+            events->setEnabled(shouldReport);
 }
 
 //==============================================================================
@@ -290,7 +446,7 @@ bool TryGranulatorAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* TryGranulatorAudioProcessor::createEditor()
 {
-    return new juce::GenericAudioProcessorEditor (*this);
+    return new TryGranulatorAudioProcessorEditor (*this);
 }
 
 //==============================================================================
@@ -307,7 +463,52 @@ void TryGranulatorAudioProcessor::setStateInformation (const void* data, int siz
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState.get() != nullptr)
     if (xmlState ->hasTagName (apvts.state.getType()))
-    apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+    {
+        apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+        applyCustomEnvelopeFromState();
+    }
+}
+
+/**
+ sets the user-drawn grain envelope used by the "Custom" envelope choice and stores it with the plugin state
+ 
+ @param points breakpoints in 0 to 1 on both axes, sorted by x
+ */
+void TryGranulatorAudioProcessor::setCustomEnvelope(const juce::Array<juce::Point<float>>& points)
+{
+    juce::StringArray pairs;
+    for (auto& p : points)
+        pairs.add (juce::String (p.x) + "," + juce::String (p.y));
+    
+    apvts.state.getOrCreateChildWithName ("CustomEnvelope", nullptr).setProperty ("points", pairs.joinIntoString (";"), nullptr);
+    envelopeTables.setCustomShape (points);
+}
+
+/**
+ Returns the user-drawn grain envelope saved in the plugin state - empty until one has been drawn
+ */
+juce::Array<juce::Point<float>> TryGranulatorAudioProcessor::getCustomEnvelope() const
+{
+    juce::Array<juce::Point<float>> points;
+    auto saved = apvts.state.getChildWithName ("CustomEnvelope").getProperty ("points").toString();
+    
+    for (auto& pair : juce::StringArray::fromTokens (saved, ";", ""))
+        points.add ({ pair.upToFirstOccurrenceOf (",", false, false).getFloatValue(),
+                      pair.fromFirstOccurrenceOf (",", false, false).getFloatValue() });
+    
+    return points;
+}
+
+/**
+ rebuilds the custom envelope table from the points saved in the plugin state
+ */
+void TryGranulatorAudioProcessor::applyCustomEnvelopeFromState()
+{
+    auto points = getCustomEnvelope();
+    if (points.isEmpty())
+        return;
+    
+    envelopeTables.setCustomShape (points);
 }
 
 //==============================================================================
@@ -318,48 +519,42 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 }
 
 /**
- loads a file from disk and stores it in the plugin's sampleBuffer
+ loads a file from disk as the plugin's sample source, in the background - WAV files are mapped rather than read into memory.
+ Playback carries on with the current sample until the new one is ready.
  */
 void TryGranulatorAudioProcessor::loadSample(const juce::String& path)
 {
-    juce::File file(path);
-    auto* reader = formatManager.createReaderFor(file);
-    if (reader)
-    {
-        sampleBuffer.reset(new juce::AudioBuffer<float>(reader->numChannels, (int)reader->lengthInSamples));
-        
-        // read sample into buffer starting from 0
-        reader->read(sampleBuffer.get(), 0, (int)reader->lengthInSamples, 0 , true, true);
-        delete reader;
-    }
+    sampleLoader.loadFile(juce::File(path));
 }
 
 /**
- loads the sample from binary data into the sampleBuffer
+ blocks until the samples requested with loadSample have loaded - for offline use, never the audio thread
+ 
+ @param timeoutMs int - -1 to wait forever
+ @return false if it timed out
  */
-void TryGranulatorAudioProcessor::loadSampleFromMemory()
+bool TryGranulatorAudioProcessor::waitForSampleLoad(int timeoutMs)
 {
-    formatManager.registerBasicFormats();
+    return sampleLoader.waitUntilIdle(timeoutMs);
+}
 
-    // Wrap binary sample data in JUCE MemoryInputStream
-    std::unique_ptr<juce::MemoryInputStream> inputStream =
-        std::make_unique<juce::MemoryInputStream>(
-            BinaryData::Ad_Privatecaller_wav,
-            BinaryData::Ad_Privatecaller_wavSize,
-            false
-        );
+/**
+ whether the last sample requested with loadSample couldn't be read - the previous sample is still the one playing
+ */
+bool TryGranulatorAudioProcessor::didSampleLoadFail() const
+{
+    return sampleLoadFailed;
+}
 
-    if (inputStream)
-    {
-        // create reader from input stream
-        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(std::move(inputStream)));
+/**
+ loads the sample from binary data into the sample source - every instance shares the one decoded copy
+ */
+void TryGranulatorAudioProcessor::loadSampleFromMemory()
+{
+    formatManager.registerBasicFormats();
 
-        if (reader)
-        {
-            sampleBuffer.reset(new juce::AudioBuffer<float>(reader->numChannels, (int)reader->lengthInSamples));
-            
-            // read into audio buffer
-            reader->read(sampleBuffer.get(), 0, (int)reader->lengthInSamples, 0, true, true);
-        }
-    }
+    if (auto source = GrainSourceCache::getInstance().getOrDecode(BinaryData::Ad_Privatecaller_wav,
+                                                                  (size_t) BinaryData::Ad_Privatecaller_wavSize,
+                                                                  formatManager))
+        sampleLoader.publish(source);
 }
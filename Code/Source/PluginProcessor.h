@@ -10,6 +10,13 @@
 
 #include <JuceHeader.h>
 #include "Grain.h"
+#include "EnvelopeTables.h"
+#include "EngineTelemetry.h"
+#include "FdnReverb.h"
+#include "GrainBudget.h"
+#include "GrainSampler.h"
+#include "SampleLoader.h"
+#include "StereoFilter.h"
 
 //==============================================================================
 /**
@@ -55,20 +62,63 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     
     void loadSample(const juce::String& path);
+    bool waitForSampleLoad(int timeoutMs = -1);
+    bool didSampleLoadFail() const;
     void loadSampleFromMemory();
+    
+    void setCustomEnvelope(const juce::Array<juce::Point<float>>& points);
+    juce::Array<juce::Point<float>> getCustomEnvelope() const;
+    
+    uint32_t getNumDroppedGrains();
+    uint32_t getNumCulledGrains();
+    int getNumActiveGrains();
+    float getPredictedGrainLoad() const;
+    
+    EngineTelemetry& getTelemetry() { return telemetry; }
+    TelemetryMonitor& getTelemetryMonitor() { return telemetryMonitor; }
+    
+    // grain spawns and retires for the editor, one queue per voice - only filled while enabled
+    int getNumGrainVoices() const { return synth.getNumVoices(); }
+    GrainEventQueue* getGrainEvents(int voiceIndex);
+    void setGrainEventsEnabled(bool shouldReport);
+    const SampleOverview& getSampleOverview() const { return sampleOverview; }
 
 private:
     // Handles audio format registration and decoding (WAV, AIFF, MP3, etc.)
     juce::AudioFormatManager formatManager;
     
-    // Pointer to loaded sample used for sample-based granulation
-    std::unique_ptr<juce::AudioBuffer<float>> sampleBuffer;
+    // keeps the pages of a mapped sample that grains are about to read resident
+    SamplePageWarmer pageWarmer;
+    
+    // outline of the published sample for the editor, rebuilt off the audio thread
+    SampleOverview sampleOverview;
+    
+    // set from the loader thread when a requested file can't be read, cleared when a sample is published
+    std::atomic<bool> sampleLoadFailed { false };
+    
+    // Loads samples in the background and hands them to the audio thread (declared after what it calls back into)
+    SampleLoader sampleLoader { formatManager };
+    
+    // Sample used for sample-based granulation, decoded or memory-mapped - only touched in processBlock
+    GrainSampleSource::Ptr audioSource;
+    
+    // Envelope shapes shared by all grains, built in prepareToPlay
+    GrainEnvelopeTables envelopeTables;
+    void applyCustomEnvelopeFromState();
+    
+    // JUCE synthesiser object managing GrainVoice and GrainSound, optionally rendering voices in parallel
+    GrainSynthesiser synth;
+    static constexpr int numVoices = 3; // can increase this, depending on CPU power
+    static_assert (2 * numVoices <= SamplePageWarmer::maxReadHeads, "the page warmer follows two read heads per voice");
+    static_assert (2 * numVoices <= SampleLoader::maxHolders, "the sample loader is told two sources per voice");
     
-    // Global grain array
-    juce::Array<Grain> grains;
+    // Caps the grains alive across all voices, tightened further when blocks take too long
+    GrainBudget grainBudget;
     
-    // JUCE synthesiser object managing GrainVoice and GrainSound
-    juce::Synthesiser synth;
+    // What each block cost and what the voices did in it, written by processBlock and read on the message thread
+    EngineTelemetry telemetry;
+    TelemetryMonitor telemetryMonitor { telemetry };
+    void recordBlock(double renderSeconds, int numSamples);
     
     // Manages all plugin parameters and their mapping
     juce::AudioProcessorValueTreeState apvts;
@@ -76,9 +126,14 @@ private:
     // Raw pointers to parametrs
     std::atomic<float>* reverbOnParam;
     std::atomic<float>* reverbMixParam;
+    std::atomic<float>* reverbSizeParam;
+    std::atomic<float>* reverbDecayParam;
+    std::atomic<float>* reverbDampingParam;
     std::atomic<float>* filterCutoffParam;
     std::atomic<float>* filterTypeParam;
     std::atomic<float>* filterResonanceParam;
+    std::atomic<float>* parallelVoicesParam;
+    std::atomic<float>* grainLimitParam;
     
     
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
@@ -90,7 +145,13 @@ private:
         params.push_back (std::make_unique<juce::AudioParameterChoice>(juce::ParameterID("Mode", 1), "Granular Mode", juce::StringArray ("Delay", "Sample"), 0));
         
         // Envelope type for amplitude shaping
-        params.push_back (std::make_unique<juce::AudioParameterChoice>(juce::ParameterID("Envelope", 1), "Grain Envelope", juce::StringArray ("Triangle", "Hann", "Exponential", "Trapezoid"), 0));
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(juce::ParameterID("Envelope", 1), "Grain Envelope", juce::StringArray ("Triangle", "Hann", "Exponential", "Trapezoid", "Custom"), 0));
+        
+        // How grains read between source samples - quality against CPU
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(juce::ParameterID("Interpolation", 1), "Interpolation", juce::StringArray ("Nearest", "Linear", "Cubic", "Sinc"), 2));
+        
+        // How grain onsets are spaced - evenly, or as a random (Poisson) cloud with the same average density
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(juce::ParameterID("Scheduling", 1), "Grain Timing", juce::StringArray ("Periodic", "Cloud"), 0));
         
         // Grain duration in milliseconds
         params.push_back (std::make_unique<juce::AudioParameterInt>(juce::ParameterID("Length", 1), "Grain Length", 5, 2000, 500));
@@ -101,6 +162,9 @@ private:
         // Time between grain spawns (lower = more grains)
         params.push_back (std::make_unique<juce::AudioParameterInt>(juce::ParameterID("Density", 1), "Density", 2, 500, 50));
         
+        // Most grains alive at once across all voices - past it grains are spaced out and the quietest fade early
+        params.push_back (std::make_unique<juce::AudioParameterInt>(juce::ParameterID("GrainLimit", 1), "Grain Limit", GrainBudget::minGrains, 6000, 1024));
+        
         // Maximum number of active overlapping grain streams
         params.push_back (std::make_unique<juce::AudioParameterInt>(juce::ParameterID("Activity", 1), "Activity", 1, 10, 3));
         
@@ -146,25 +210,36 @@ private:
         // Dry/wet mix for reverb
         params.push_back(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("ReverbMix", 1), "Reverb Mix", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.3f));
         
+        // Room size - scales the reverb's delay lines
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("ReverbSize", 1), "Reverb Size", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.3f));
+        
+        // Seconds for the reverb tail to fall by 60 dB
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("ReverbDecay", 1), "Reverb Decay", juce::NormalisableRange<float>(0.1f, 20.0f, 0.01f, 0.3f), 1.5f));
+        
+        // How quickly the high end of the tail dies away
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("ReverbDamping", 1), "Reverb Damping", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+        
         // Internal delay line feedback
         params.push_back(std::make_unique<juce::AudioParameterFloat> (juce::ParameterID("Feedback", 1), "Feedback Amt", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
         
         // how much of the grain output is fed back into the delay line
         params.push_back(std::make_unique<juce::AudioParameterFloat> (juce::ParameterID("GrainFeedback", 1), "Grain Feedback", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
 
+        // Render the held voices on several cores
+        params.push_back(std::make_unique<juce::AudioParameterBool>(juce::ParameterID("ParallelVoices", 1), "Parallel Voices", false));
+        
+        // Seed for all grain randomisation - the same seed renders the same cloud
+        params.push_back(std::make_unique<juce::AudioParameterInt>(juce::ParameterID("Seed", 1), "Seed", 0, 9999, 0));
+
         return {params.begin(), params.end()};
     }
 
-    // Reverb Processor
-    juce::Reverb reverb;
-    juce::Reverb::Parameters reverbParams;
-    
-    // Smoothed variables
-    juce::SmoothedValue<float> smoothedReverbMix; // for reverb blend
+    // Reverb Processor - allocated in prepareToPlay, mixes into the block in place
+    FdnReverb reverb;
+    bool reverbWasOn = false;
     
     // Filtering
-    juce::IIRFilter filterL;
-    juce::IIRFilter filterR;
+    StereoFilter filter;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TryGranulatorAudioProcessor)
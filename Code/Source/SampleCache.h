@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    SampleCache.h
+    Created: 18 Oct 2026 3:14:06pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainSourceCache - one copy of each sample for the whole process
+
+ Every plugin instance in a session used to decode the embedded sample into its own buffer.
+ Sources are immutable and reference-counted, so instances can share them instead: this cache
+ hands out the source already built from the same audio, and only decodes on a miss.
+
+ Decoded audio is keyed by a 64-bit hash of the encoded bytes plus their size, so the embedded
+ sample and identical files share one buffer wherever they come from. Memory-mapped WAV files
+ have no buffer of their own to share (the OS already shares their pages), and hashing one would
+ read the whole file from disk, so they are keyed by path, size and modification time instead.
+
+ The cache holds a reference to each source; a source nobody else holds any more is dropped on
+ the next lookup, or as soon as a SampleLoader lets go of it. Safe to use from any thread except the audio one.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include "SampleSource.h"
+
+class GrainSourceCache
+{
+public:
+    static GrainSourceCache& getInstance()
+    {
+        static GrainSourceCache cache;
+        return cache;
+    }
+
+    /**
+     returns the source decoded from these bytes, decoding them first if nobody has yet
+     @param data const void* - an encoded audio file held in memory, e.g. from BinaryData
+     @param size size_t
+     @param formatManager juce::AudioFormatManager& - with the formats to decode registered
+     @return nullptr if the data can't be decoded
+     */
+    GrainSampleSource::Ptr getOrDecode (const void* data, size_t size, juce::AudioFormatManager& formatManager)
+    {
+        const Key key { hashBytes (data, size), (juce::uint64) size, false };
+
+        if (auto cached = find (key))
+            return cached;
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (std::make_unique<juce::MemoryInputStream> (data, size, false)));
+        return insert (key, GrainSampleSource::fromReader (std::move (reader)));
+    }
+
+    /**
+     returns the source for a file, mapping or decoding it first if nobody has yet
+     @param file const juce::File&
+     @param formatManager juce::AudioFormatManager& - with the formats to decode registered
+     @return nullptr if the file can't be read
+     */
+    GrainSampleSource::Ptr getOrLoad (const juce::File& file, juce::AudioFormatManager& formatManager)
+    {
+        const Key fileKey { (juce::uint64) file.getFullPathName().hashCode64() ^ (juce::uint64) file.getLastModificationTime().toMilliseconds(),
+                            (juce::uint64) file.getSize(), true };
+
+        if (auto cached = find (fileKey))
+            return cached;
+
+        if (auto mapped = GrainSampleSource::mapWavFile (file))
+            return insert (fileKey, mapped);
+
+        // everything else is decoded into memory, so it goes by its content
+        juce::MemoryBlock bytes;
+        if (! file.loadFileAsData (bytes))
+            return nullptr;
+
+        return getOrDecode (bytes.getData(), bytes.getSize(), formatManager);
+    }
+
+    /**
+     whether the cache still holds this source - i.e. it hasn't been purged yet
+     @param source const GrainSampleSource*
+     */
+    bool contains (const GrainSampleSource* source) const
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (auto& entry : sources)
+            if (entry.second.get() == source)
+                return true;
+
+        return false;
+    }
+
+    /**
+     drops every source that only the cache still holds
+     */
+    void purgeUnused()
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (auto it = sources.begin(); it != sources.end();)
+            it = it->second->getReferenceCount() == 1 ? sources.erase (it) : std::next (it);
+    }
+
+private:
+    GrainSourceCache() = default;
+
+    struct Key
+    {
+        juce::uint64 hash;
+        juce::uint64 size;
+        bool mapped;
+
+        bool operator< (const Key& other) const
+        {
+            return std::tie (hash, size, mapped) < std::tie (other.hash, other.size, other.mapped);
+        }
+    };
+
+    GrainSampleSource::Ptr find (const Key& key)
+    {
+        const juce::ScopedLock sl (lock);
+        auto it = sources.find (key);
+
+        if (it == sources.end())
+            return nullptr;
+
+        return it->second;
+    }
+
+    // two threads may decode the same audio at once - the first one in wins, the other copy is dropped
+    GrainSampleSource::Ptr insert (const Key& key, GrainSampleSource::Ptr source)
+    {
+        if (source == nullptr)
+            return nullptr;
+
+        purgeUnused();
+
+        const juce::ScopedLock sl (lock);
+        auto& entry = sources[key];
+
+        if (entry == nullptr)
+            entry = source;
+
+        return entry;
+    }
+
+    // FNV-1a over 64-bit words, with a fold so the high bits of each word reach the low bits of the hash
+    static juce::uint64 hashBytes (const void* data, size_t size)
+    {
+        constexpr juce::uint64 prime = 1099511628211ull;
+        auto* bytes = static_cast<const char*> (data);
+        juce::uint64 hash = 14695981039346656037ull;
+        size_t i = 0;
+
+        for (; i + 8 <= size; i += 8)
+        {
+            juce::uint64 word;
+            std::memcpy (&word, bytes + i, 8);
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 32;
+        }
+
+        for (; i < size; ++i)
+            hash = (hash ^ (juce::uint8) bytes[i]) * prime;
+
+        return hash;
+    }
+
+    juce::CriticalSection lock;
+    std::map<Key, GrainSampleSource::Ptr> sources;
+
+    JUCE_DECLARE_NON_COPYABLE (GrainSourceCache)
+};
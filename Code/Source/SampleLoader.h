@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+
+    SampleLoader.h
+    Created: 18 Oct 2026 10:37:52am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class SampleLoader - decodes samples in the background and hands them to the audio thread
+
+ Files are opened on the loader's own thread, through the process-wide GrainSourceCache, so loading
+ never holds up the caller or the audio callback and a file another instance already has is shared. A finished source is published by swapping one atomic pointer; the audio thread picks
+ it up at the start of its next block with acquireLatest(), which only reads atomics and moves
+ reference counts, so it never blocks, allocates or frees.
+
+ Every published source is also kept in a retain list. Nothing the audio thread lets go of can
+ reach a reference count of zero, because the list (and the cache) still holds it. The reference
+ count itself says nothing about this instance - other instances share the cached sources - so
+ every block the audio thread publishes the sources its own players still read with setHeld().
+ The loader thread drops a source from the list once it is neither published nor held, and then
+ purges the cache, which frees it as soon as no other instance's list has it either, so the actual
+ delete always happens on a loader thread. A single hazard pointer covers the moment between the
+ audio thread reading the published pointer and setHeld() naming it.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleCache.h"
+
+class SampleLoader : private juce::Thread
+{
+public:
+    /**
+     @param formats juce::AudioFormatManager& - decoders for files that can't be mapped, must outlive the loader
+     */
+    explicit SampleLoader (juce::AudioFormatManager& formats)
+        : juce::Thread ("Sample loader"), formatManager (formats)
+    {
+        idle.signal();
+        startThread (juce::Thread::Priority::background);
+    }
+
+    ~SampleLoader() override
+    {
+        stop();
+
+        // whatever this instance was the last user of can leave the cache now
+        retained.clear();
+        GrainSourceCache::getInstance().purgeUnused();
+    }
+
+    /**
+     called on the publishing thread (the loader thread for loadFile) with every source that is published
+     */
+    std::function<void (GrainSampleSource::Ptr)> onPublished;
+
+    /**
+     called on the loader thread with every file that couldn't be read - whatever was playing carries on
+     */
+    std::function<void (const juce::File&)> onLoadFailed;
+
+    /**
+     opens a file in the background and publishes it when it is ready. If several requests queue up
+     before the loader gets to them, only the newest is loaded. Never from the audio thread.
+     @param file const juce::File&
+     */
+    void loadFile (const juce::File& file)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+            pendingFile = file;
+            hasPendingFile = true;
+            idle.reset();
+        }
+
+        notify();
+    }
+
+    /**
+     waits until every requested file has been loaded (or failed to load)
+     @param timeoutMs int - -1 to wait forever
+     @return false if it timed out
+     */
+    bool waitUntilIdle (int timeoutMs = -1)
+    {
+        return idle.wait (timeoutMs);
+    }
+
+    /**
+     makes a source the one the audio thread plays - never from the audio thread
+     @param source GrainSampleSource::Ptr - nullptr for silence
+     */
+    void publish (GrainSampleSource::Ptr source)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+
+            if (source != nullptr && ! retained.contains (source.get()))
+                retained.add (source);
+
+            published.store (source.get());
+        }
+
+        if (onPublished)
+            onPublished (source);
+
+        // the previous source is reclaimed on the loader thread once the audio thread is done with it
+        notify();
+    }
+
+    static constexpr int maxHolders = 8;
+
+    /**
+     points current at the most recently published source. Audio thread only: lock-free, allocation-free,
+     and the reference it drops is never the last one. The new source stays protected until the next setHeld().
+     @param current GrainSampleSource::Ptr& - the source the caller is playing, updated in place
+     @return true if current changed
+     */
+    bool acquireLatest (GrainSampleSource::Ptr& current)
+    {
+        auto* latest = published.load();
+        if (latest == current.get())
+            return false;
+
+        // announce the source before relying on it, then check it is still the published one -
+        // reclaim() reads the hazard after the published pointer, so it can't drop it in between
+        for (;;)
+        {
+            hazard.store (latest);
+            auto* check = published.load();
+
+            if (check == latest)
+                break;
+
+            latest = check;
+        }
+
+        current = latest;
+        return true;
+    }
+
+    /**
+     tells the loader which sources the audio thread's players still read, so none of them is reclaimed.
+     Audio thread, every block, once acquireLatest's source has been handed on. Sources only ever pass
+     from current to later entries of others (a voice's playing source before its retiring one): the
+     entries are stored from the last to the first and current after them, and reclaim() reads them
+     the other way round, so a source on the move is always found in one place or the other.
+     @param current const GrainSampleSource* - the source acquireLatest keeps up to date
+     @param others const GrainSampleSource* const* - what the players hold, nullptr for nothing
+     @param numOthers int - at most maxHolders
+     */
+    void setHeld (const GrainSampleSource* current, const GrainSampleSource* const* others, int numOthers)
+    {
+        jassert (numOthers <= maxHolders);
+
+        for (int i = maxHolders; --i >= 0;)
+            holders[(size_t) i].store (i < numOthers ? others[i] : nullptr);
+
+        heldCurrent.store (current);
+        hazard.store (nullptr);
+    }
+
+    /**
+     stops the loader thread, dropping any file that hasn't started loading - call before whatever onPublished uses goes away
+     */
+    void stop()
+    {
+        {
+            const juce::ScopedLock sl (lock);
+            hasPendingFile = false;
+        }
+
+        stopThread (4000);
+        idle.signal();
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            juce::File file;
+            bool loadNow = false;
+
+            {
+                const juce::ScopedLock sl (lock);
+                std::swap (loadNow, hasPendingFile);
+                file = pendingFile;
+            }
+
+            if (loadNow)
+            {
+                if (auto source = GrainSourceCache::getInstance().getOrLoad (file, formatManager))
+                    publish (source);
+                else if (onLoadFailed)
+                    onLoadFailed (file);
+
+                const juce::ScopedLock sl (lock);
+                if (! hasPendingFile)
+                    idle.signal();
+            }
+
+            // poll while an old source is still waiting for the audio thread to let go of it
+            wait (reclaim() ? -1 : 100);
+        }
+    }
+
+    /**
+     drops every retained source this instance no longer publishes or plays, and then the cache's copy
+     of it if no other instance has it either
+     @return true if only the published source is left
+     */
+    bool reclaim()
+    {
+        bool dropped = false;
+        bool onlyPublishedLeft = false;
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            // order matters: published, then the hazard, then current, then the other holders (see acquireLatest and setHeld)
+            std::array<const GrainSampleSource*, maxHolders + 3> inUse;
+            inUse[0] = published.load();
+            inUse[1] = hazard.load();
+            inUse[2] = heldCurrent.load();
+
+            for (int i = 0; i < maxHolders; ++i)
+                inUse[(size_t) i + 3] = holders[(size_t) i].load();
+
+            for (int i = retained.size(); --i >= 0;)
+            {
+                if (std::find (inUse.begin(), inUse.end(), retained.getObjectPointerUnchecked (i)) == inUse.end())
+                {
+                    retained.remove (i);
+                    dropped = true;
+                }
+            }
+
+            onlyPublishedLeft = retained.size() <= (inUse[0] != nullptr ? 1 : 0);
+        }
+
+        // outside the lock: this is where a replaced sample is actually freed or unmapped
+        if (dropped)
+            GrainSourceCache::getInstance().purgeUnused();
+
+        return onlyPublishedLeft;
+    }
+
+    juce::AudioFormatManager& formatManager;
+
+    juce::CriticalSection lock;
+    juce::File pendingFile;
+    bool hasPendingFile = false;
+    juce::WaitableEvent idle { true };
+
+    juce::ReferenceCountedArray<GrainSampleSource> retained;
+    std::atomic<GrainSampleSource*> published { nullptr };
+    std::atomic<GrainSampleSource*> hazard { nullptr };
+    std::atomic<const GrainSampleSource*> heldCurrent { nullptr };
+    std::array<std::atomic<const GrainSampleSource*>, maxHolders> holders {};
+
+    JUCE_DECLARE_NON_COPYABLE (SampleLoader)
+};
@@ -0,0 +1,691 @@
+/*
+  ==============================================================================
+
+    SampleSource.h
+    Created: 17 Oct 2026 7:12:35pm
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class GrainSampleSource - the audio that Sample mode cuts its grains from
+
+ Uncompressed WAV files are memory-mapped and read in place, so an hour-long field recording
+ only costs the pages grains actually touch, and lengths are 64-bit so nothing overflows past
+ 2^31 samples. Everything else (the embedded sample, compressed or big-endian files) is decoded
+ into memory once. Either way the audio is stored as interleaved frames, and the voices read it
+ through a Reader: a small copyable accessor holding the frame pointer and the sample encoding,
+ that converts to float as it reads.
+
+ Decoded sources also carry a pyramid of octave-decimated copies (level 1 is half the rate of the
+ source, level 2 a quarter, ...), each low-passed at its own Nyquist before decimating. Grains
+ playing faster than the source read from the level matching their rate, so high notes don't alias
+ and read from small buffers that stay in cache; see getLevelFor(). Octave levels add up to at most
+ the size of the source, so the depth is capped at maxLevels, which keeps them under 7/8 of it.
+ Mapped sources have no pyramid - building one would read the whole file into memory.
+
+ A source never changes once it is built. It is reference-counted, so the voices, the page warmer
+ and the loader (see SampleLoader.h) can share it and the last one to let go frees it.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstring>
+
+class GrainSampleSource : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<GrainSampleSource>;
+
+    // level 0 is the source itself, so rates up to 2^(maxLevels - 1) get a level of their own
+    static constexpr int maxLevels = 4;
+
+    enum class Encoding
+    {
+        float32,
+        int16,
+        int24,
+        int32
+    };
+
+    //==============================================================================
+    /**
+     lightweight accessor the grain kernel and the dry signal read through - copy it by value
+     */
+    struct Reader
+    {
+        const char* frames = nullptr;
+        int bytesPerFrame = 0;
+        int numChannels = 0;
+        int rightChannel = 0; // 1 for stereo sources, 0 so mono sources play on both sides
+        juce::int64 lastSample = -1;
+        Encoding encoding = Encoding::float32;
+
+        /**
+         Returns one sample as float
+         @param channel int
+         @param index juce::int64 - clamped to the source
+         */
+        float sample (int channel, juce::int64 index) const
+        {
+            index = juce::jlimit ((juce::int64) 0, lastSample, index);
+            return convert (frames + index * bytesPerFrame, channel);
+        }
+
+        /**
+         copies numTaps consecutive left and right samples from index first into column lane of the
+         tap rows, used by the grain kernel. Taps hanging over either end repeat the edge sample.
+         */
+        template <int numTaps, int lanes>
+        void gather (juce::int64 first, int lane, float (*l)[lanes], float (*r)[lanes]) const
+        {
+            switch (encoding)
+            {
+                case Encoding::int16: gatherAs<Encoding::int16, numTaps> (first, lane, l, r); break;
+                case Encoding::int24: gatherAs<Encoding::int24, numTaps> (first, lane, l, r); break;
+                case Encoding::int32: gatherAs<Encoding::int32, numTaps> (first, lane, l, r); break;
+                default:              gatherAs<Encoding::float32, numTaps> (first, lane, l, r); break;
+            }
+        }
+
+        /**
+         copies a run of consecutive left and right samples, used to feed the delay line. Indices past
+         either end repeat the edge sample.
+         @param first juce::int64
+         @param left float*
+         @param right float*
+         @param numFrames int
+         */
+        void read (juce::int64 first, float* left, float* right, int numFrames) const
+        {
+            switch (encoding)
+            {
+                case Encoding::int16: readAs<Encoding::int16> (first, left, right, numFrames); break;
+                case Encoding::int24: readAs<Encoding::int24> (first, left, right, numFrames); break;
+                case Encoding::int32: readAs<Encoding::int32> (first, left, right, numFrames); break;
+                default:              readAs<Encoding::float32> (first, left, right, numFrames); break;
+            }
+        }
+
+    private:
+        template <Encoding enc>
+        void readAs (juce::int64 first, float* left, float* right, int numFrames) const
+        {
+            if (first >= 0 && first + numFrames - 1 <= lastSample)
+            {
+                const char* frame = frames + first * bytesPerFrame;
+
+                for (int i = 0; i < numFrames; ++i, frame += bytesPerFrame)
+                {
+                    left[i] = convertAs<enc> (frame, 0);
+                    right[i] = convertAs<enc> (frame, rightChannel);
+                }
+                return;
+            }
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                const char* frame = frames + juce::jlimit ((juce::int64) 0, lastSample, first + i) * bytesPerFrame;
+                left[i] = convertAs<enc> (frame, 0);
+                right[i] = convertAs<enc> (frame, rightChannel);
+            }
+        }
+
+        template <Encoding enc, int numTaps, int lanes>
+        void gatherAs (juce::int64 first, int lane, float (*l)[lanes], float (*r)[lanes]) const
+        {
+            if (first >= 0 && first + numTaps - 1 <= lastSample)
+            {
+                const char* frame = frames + first * bytesPerFrame;
+
+                for (int k = 0; k < numTaps; ++k, frame += bytesPerFrame)
+                {
+                    l[k][lane] = convertAs<enc> (frame, 0);
+                    r[k][lane] = convertAs<enc> (frame, rightChannel);
+                }
+                return;
+            }
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const char* frame = frames + juce::jlimit ((juce::int64) 0, lastSample, first + k) * bytesPerFrame;
+                l[k][lane] = convertAs<enc> (frame, 0);
+                r[k][lane] = convertAs<enc> (frame, rightChannel);
+            }
+        }
+
+        float convert (const char* frame, int channel) const
+        {
+            switch (encoding)
+            {
+                case Encoding::int16: return convertAs<Encoding::int16> (frame, channel);
+                case Encoding::int24: return convertAs<Encoding::int24> (frame, channel);
+                case Encoding::int32: return convertAs<Encoding::int32> (frame, channel);
+                default:              return convertAs<Encoding::float32> (frame, channel);
+            }
+        }
+
+        // WAV data is little-endian and may sit at any byte offset, hence memcpy rather than a cast
+        template <Encoding enc>
+        static float convertAs (const char* frame, int channel)
+        {
+            if constexpr (enc == Encoding::float32)
+            {
+                float value;
+                std::memcpy (&value, frame + channel * 4, 4);
+                return value;
+            }
+            else if constexpr (enc == Encoding::int16)
+            {
+                int16_t value;
+                std::memcpy (&value, frame + channel * 2, 2);
+                return float (value) * (1.0f / 32768.0f);
+            }
+            else if constexpr (enc == Encoding::int24)
+            {
+                auto* bytes = reinterpret_cast<const uint8_t*> (frame + channel * 3);
+                const int32_t value = int32_t ((uint32_t (bytes[0]) << 8) | (uint32_t (bytes[1]) << 16) | (uint32_t (bytes[2]) << 24)) >> 8;
+                return float (value) * (1.0f / 8388608.0f);
+            }
+            else
+            {
+                int32_t value;
+                std::memcpy (&value, frame + channel * 4, 4);
+                return float (value) * (1.0f / 2147483648.0f);
+            }
+        }
+    };
+
+    //==============================================================================
+    /**
+     decodes everything a reader holds into memory
+     @param reader std::unique_ptr<juce::AudioFormatReader>
+     */
+    static Ptr fromReader (std::unique_ptr<juce::AudioFormatReader> reader)
+    {
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels <= 0)
+            return nullptr;
+
+        Ptr source (new GrainSampleSource());
+        source->numChannels = (int) reader->numChannels;
+        source->lengthInSamples = reader->lengthInSamples;
+        source->sampleRate = reader->sampleRate;
+        source->encoding = Encoding::float32;
+        source->bytesPerFrame = source->numChannels * (int) sizeof (float);
+        source->decoded.allocate ((size_t) (source->lengthInSamples * source->numChannels), false);
+
+        // decode a chunk at a time and interleave it
+        const int chunkSize = 65536;
+        juce::AudioBuffer<float> chunk (source->numChannels, chunkSize);
+
+        for (juce::int64 start = 0; start < source->lengthInSamples; start += chunkSize)
+        {
+            const int num = (int) juce::jmin ((juce::int64) chunkSize, source->lengthInSamples - start);
+            reader->read (&chunk, 0, num, start, true, true);
+
+            float* dest = source->decoded.get() + start * source->numChannels;
+            for (int i = 0; i < num; ++i)
+                for (int ch = 0; ch < source->numChannels; ++ch)
+                    *dest++ = chunk.getSample (ch, i);
+        }
+
+        source->frames = reinterpret_cast<const char*> (source->decoded.get());
+        source->buildLevels();
+        return source;
+    }
+
+    /**
+     maps the data chunk of an uncompressed little-endian PCM or float WAV file, or returns nullptr
+     @param file const juce::File&
+     */
+    static Ptr mapWavFile (const juce::File& file)
+    {
+        if (! file.hasFileExtension ("wav;wave"))
+            return nullptr;
+
+        auto map = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly, false);
+        auto* data = static_cast<const char*> (map->getData());
+        const auto size = (juce::int64) map->getSize();
+
+        if (data == nullptr || size < 12 || std::memcmp (data, "RIFF", 4) != 0 || std::memcmp (data + 8, "WAVE", 4) != 0)
+            return nullptr;
+
+        Ptr source (new GrainSampleSource());
+        int formatTag = 0, bitsPerSample = 0, blockAlign = 0;
+        juce::int64 dataStart = 0, dataSize = 0;
+
+        for (juce::int64 pos = 12; pos + 8 <= size;)
+        {
+            const auto chunkSize = (juce::int64) juce::ByteOrder::littleEndianInt (data + pos + 4);
+            const char* body = data + pos + 8;
+
+            if (std::memcmp (data + pos, "fmt ", 4) == 0 && chunkSize >= 16 && pos + 8 + chunkSize <= size)
+            {
+                formatTag = juce::ByteOrder::littleEndianShort (body);
+                source->numChannels = juce::ByteOrder::littleEndianShort (body + 2);
+                source->sampleRate = juce::ByteOrder::littleEndianInt (body + 4);
+                blockAlign = juce::ByteOrder::littleEndianShort (body + 12);
+                bitsPerSample = juce::ByteOrder::littleEndianShort (body + 14);
+
+                // WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start of the sub-format GUID
+                if (formatTag == 0xfffe && chunkSize >= 40)
+                    formatTag = juce::ByteOrder::littleEndianShort (body + 24);
+            }
+            else if (std::memcmp (data + pos, "data", 4) == 0)
+            {
+                dataStart = pos + 8;
+                dataSize = juce::jmin (chunkSize, size - dataStart); // tolerate a truncated final chunk
+                break;
+            }
+
+            pos += 8 + chunkSize + (chunkSize & 1);
+        }
+
+        if (formatTag == 1 && bitsPerSample == 16)       source->encoding = Encoding::int16;
+        else if (formatTag == 1 && bitsPerSample == 24)  source->encoding = Encoding::int24;
+        else if (formatTag == 1 && bitsPerSample == 32)  source->encoding = Encoding::int32;
+        else if (formatTag == 3 && bitsPerSample == 32)  source->encoding = Encoding::float32;
+        else return nullptr;
+
+        if (source->numChannels <= 0 || blockAlign != source->numChannels * bitsPerSample / 8 || dataStart == 0)
+            return nullptr;
+
+        source->bytesPerFrame = blockAlign;
+        source->lengthInSamples = dataSize / blockAlign;
+
+        if (source->lengthInSamples <= 0)
+            return nullptr;
+
+        source->frames = data + dataStart;
+        source->mappedFile = std::move (map);
+        return source;
+    }
+
+    //==============================================================================
+    /**
+     Returns a reader for the source, or for one of its decimated levels
+     @param level int - 0 for the source itself, up to getNumLevels() - 1
+     */
+    Reader getReader (int level = 0) const
+    {
+        Reader reader;
+        reader.numChannels = numChannels;
+        reader.rightChannel = numChannels > 1 ? 1 : 0;
+
+        if (level <= 0 || level >= numLevels)
+        {
+            reader.frames = frames;
+            reader.bytesPerFrame = bytesPerFrame;
+            reader.lastSample = lengthInSamples - 1;
+            reader.encoding = encoding;
+        }
+        else
+        {
+            reader.frames = reinterpret_cast<const char*> (levelFrames[level]);
+            reader.bytesPerFrame = numChannels * (int) sizeof (float);
+            reader.lastSample = levelLength[level] - 1;
+            reader.encoding = Encoding::float32;
+        }
+
+        return reader;
+    }
+
+    /**
+     picks the levels a grain reads from: level at 1 - blend and the next one down at blend, with
+     positions and rates divided by 2^level. Rates up to 1 always read the source itself.
+     @param rate float - playback rate of the grain, either sign
+     @param level int& - set to the finer of the two levels
+     @param blend float& - set to the weight of level + 1, 0 when there is none
+     */
+    void getLevelFor (float rate, int& level, float& blend) const
+    {
+        const float octave = std::log2 (juce::jmax (1.0f, std::abs (rate)));
+        level = juce::jmin (numLevels - 1, (int) octave);
+        blend = level < numLevels - 1 ? octave - float (level) : 0.0f;
+    }
+
+    int getNumLevels() const                { return numLevels; }
+    int getNumChannels() const              { return numChannels; }
+    juce::int64 getLengthInSamples() const  { return lengthInSamples; }
+    double getSampleRate() const            { return sampleRate; }
+    bool isMapped() const                   { return mappedFile != nullptr; }
+
+    /**
+     reads one byte from every page holding the given samples, so they are resident before a grain
+     needs them. Does nothing for decoded sources. Call it from a background thread - the first
+     touch of a page may wait for the disk.
+     @param start juce::int64
+     @param numSamples juce::int64
+     */
+    void touchPages (juce::int64 start, juce::int64 numSamples) const
+    {
+        if (! isMapped() || lengthInSamples <= 0 || numSamples <= 0)
+            return;
+
+        const juce::int64 first = juce::jlimit ((juce::int64) 0, lengthInSamples - 1, start);
+        const juce::int64 last = juce::jlimit ((juce::int64) 0, lengthInSamples - 1, start + numSamples - 1);
+        const char* begin = frames + first * bytesPerFrame;
+        const char* end = frames + (last + 1) * bytesPerFrame;
+
+        // 4 KB steps cover every page on any system this builds for
+        volatile char sink = 0;
+        for (const char* p = begin; p < end; p += 4096)
+            sink = sink + *p;
+
+        sink = sink + *(end - 1);
+    }
+
+private:
+    GrainSampleSource() = default;
+
+    /**
+     builds the decimated levels of a decoded source: each level is the one above it through a
+     half-band windowed-sinc low-pass, keeping every second sample, so sample i of level l sits
+     at sample i * 2^l of the source
+     */
+    void buildLevels()
+    {
+        constexpr int halfLength = 15; // odd taps either side of the centre, 31 in all
+        constexpr juce::int64 minLevelLength = 256;
+
+        // a half-band kernel is zero at every even offset but the centre, only the odd taps are stored
+        float taps[(halfLength + 1) / 2];
+        float sum = 0.5f;
+
+        for (int k = 1, t = 0; k <= halfLength; k += 2, ++t)
+        {
+            const double x = juce::MathConstants<double>::pi * 0.5 * k;
+            const double w = 0.5 + 0.5 * double (k) / double (halfLength + 1);
+            const double window = 0.42 - 0.5 * std::cos (2.0 * juce::MathConstants<double>::pi * w)
+                                        + 0.08 * std::cos (4.0 * juce::MathConstants<double>::pi * w);
+            taps[t] = float (0.5 * std::sin (x) / x * window);
+            sum += 2.0f * taps[t];
+        }
+
+        // unity gain at DC
+        const float centre = 0.5f / sum;
+        for (auto& tap : taps)
+            tap /= sum;
+
+        levelLength[0] = lengthInSamples;
+        juce::int64 total = 0;
+
+        while (numLevels < maxLevels && (levelLength[numLevels - 1] + 1) / 2 >= minLevelLength)
+        {
+            levelLength[numLevels] = (levelLength[numLevels - 1] + 1) / 2;
+            total += levelLength[numLevels];
+            ++numLevels;
+        }
+
+        if (numLevels == 1)
+            return;
+
+        levels.allocate ((size_t) (total * numChannels), false);
+        levelFrames[0] = decoded.get();
+
+        float* next = levels.get();
+        for (int level = 1; level < numLevels; ++level)
+        {
+            float* dest = next;
+            levelFrames[level] = next;
+            next += levelLength[level] * numChannels;
+
+            const float* above = levelFrames[level - 1];
+            const juce::int64 last = levelLength[level - 1] - 1;
+
+            for (juce::int64 i = 0; i < levelLength[level]; ++i)
+            {
+                const juce::int64 c = 2 * i;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    float value = centre * above[c * numChannels + ch];
+
+                    for (int k = 1, t = 0; k <= halfLength; k += 2, ++t)
+                    {
+                        const juce::int64 before = juce::jmax ((juce::int64) 0, c - k);
+                        const juce::int64 after = juce::jmin (last, c + k);
+                        value += taps[t] * (above[before * numChannels + ch] + above[after * numChannels + ch]);
+                    }
+
+                    *dest++ = value;
+                }
+            }
+        }
+    }
+
+    const char* frames = nullptr;
+    int bytesPerFrame = 0;
+    int numChannels = 0;
+    juce::int64 lengthInSamples = 0;
+    double sampleRate = 44100.0;
+    Encoding encoding = Encoding::float32;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile; // set for mapped sources
+    juce::HeapBlock<float> decoded;                     // set for decoded sources
+
+    // decimated levels, all in one block - level 0 is the decoded source itself
+    int numLevels = 1;
+    juce::int64 levelLength[maxLevels] {};
+    const float* levelFrames[maxLevels] {};
+    juce::HeapBlock<float> levels;
+
+    JUCE_DECLARE_NON_COPYABLE (GrainSampleSource)
+};
+
+//==============================================================================
+/**
+ @class SamplePageWarmer - keeps the part of a mapped source that grains are about to read resident
+
+ Grains of a mapped source read straight from the file mapping, and the first read of a page that
+ isn't in memory waits for the disk. This thread follows the Position, Sparse and Length parameters
+ and touches the pages around the region grains are spawned from, so that wait happens here instead
+ of on the audio thread. The dry signal and the delay input walk through the whole file as a note is
+ held: the voices publish where they read with setReadHead() once per block, and the pages ahead of
+ each of those heads are touched too, along with the start of the file where a new note begins.
+
+ The lock only guards swapping the source; the pages are touched on a copy of the pointer, so
+ setSource() never waits for the disk.
+ */
+class SamplePageWarmer : private juce::Thread
+{
+public:
+    static constexpr int maxReadHeads = 8;
+
+    SamplePageWarmer() : juce::Thread ("Sample page warmer")
+    {
+        for (auto& head : readHeads)
+            head.store (-1, std::memory_order_relaxed);
+    }
+
+    ~SamplePageWarmer() override
+    {
+        stopThread (1000);
+    }
+
+    void connectParam (juce::AudioProcessorValueTreeState& apvts)
+    {
+        positionParam = apvts.getRawParameterValue ("Position");
+        sparseParam = apvts.getRawParameterValue ("Sparse");
+        lengthParam = apvts.getRawParameterValue ("Length");
+    }
+
+    /**
+     follows a new source; starts the thread for mapped sources and stops it otherwise - never from the audio thread
+     @param newSource GrainSampleSource::Ptr - held until the next call
+     */
+    void setSource (GrainSampleSource::Ptr newSource)
+    {
+        const bool mapped = newSource != nullptr && newSource->isMapped();
+
+        {
+            const juce::ScopedLock sl (lock);
+            std::swap (source, newSource); // the old source is let go of outside the lock
+        }
+
+        if (mapped)
+            startThread (juce::Thread::Priority::background);
+        else
+            stopThread (1000);
+    }
+
+    /**
+     where a voice reads the source next - audio thread, once per block, lock-free
+     @param index int - one per read head of every voice, below maxReadHeads
+     @param sample juce::int64 - source sample, -1 while the head isn't reading
+     */
+    void setReadHead (int index, juce::int64 sample)
+    {
+        if (juce::isPositiveAndBelow (index, maxReadHeads))
+            readHeads[(size_t) index].store (sample, std::memory_order_relaxed);
+    }
+
+private:
+    void run() override
+    {
+        // grains and the dry signal may play up to two octaves up, so they can cover four times their length
+        const double maxRate = 4.0;
+        const juce::int64 maxWarmSamples = 16 * 1024 * 1024;
+
+        while (! threadShouldExit())
+        {
+            GrainSampleSource::Ptr current;
+
+            {
+                const juce::ScopedLock sl (lock);
+                current = source;
+            }
+
+            if (current != nullptr && positionParam != nullptr)
+            {
+                const auto length = current->getLengthInSamples();
+                const double sampleRate = current->getSampleRate();
+                const auto grainReach = (juce::int64) (*lengthParam * 0.001 * sampleRate * maxRate);
+                const auto centre = (juce::int64) (double (*positionParam) * double (length));
+                const auto halfSpan = juce::jmin (maxWarmSamples / 2, (juce::int64) (double (*sparseParam) * 0.5 * double (length)) + grainReach);
+
+                current->touchPages (centre - halfSpan, 2 * halfSpan);
+
+                // a few seconds ahead of every head, wrapping to the start of the file where the heads do
+                const auto ahead = juce::jmin (maxWarmSamples, (juce::int64) (aheadSeconds * sampleRate * maxRate));
+
+                for (auto& readHead : readHeads)
+                {
+                    const auto head = readHead.load (std::memory_order_relaxed);
+                    if (head < 0 || length <= 0)
+                        continue;
+
+                    const auto start = head % length;
+                    current->touchPages (start, ahead);
+                    current->touchPages (0, start + ahead - length);
+                }
+
+                current->touchPages (0, (juce::int64) (sampleRate * aheadSeconds));
+            }
+
+            // a source that was swapped out meanwhile is let go of here, the loader still holds it
+            current = nullptr;
+            wait (20);
+        }
+    }
+
+    static constexpr double aheadSeconds = 2.0;
+
+    juce::CriticalSection lock;
+    GrainSampleSource::Ptr source;
+
+    std::atomic<float>* positionParam = nullptr;
+    std::atomic<float>* sparseParam = nullptr;
+    std::atomic<float>* lengthParam = nullptr;
+
+    std::array<std::atomic<juce::int64>, maxReadHeads> readHeads;
+};
+
+//==============================================================================
+/**
+ @class SampleOverview - a min/max outline of the published source, for the editor to draw
+
+ Built on whichever thread publishes the source (the loader thread for files), never on the
+ audio thread. Each bin probes at most maxProbesPerBin frames spread across it, so a long
+ mapped file only touches a few pages per bin. The editor copies the outline out when
+ getVersion() changes.
+ */
+class SampleOverview
+{
+public:
+    static constexpr int numBins = 1024;
+
+    /**
+     rebuilds the outline from a new source - never from the audio thread
+     @param source GrainSampleSource::Ptr - nullptr clears it
+     */
+    void setSource (GrainSampleSource::Ptr source)
+    {
+        std::vector<float> newMin ((size_t) numBins, 0.0f), newMax ((size_t) numBins, 0.0f);
+
+        if (source != nullptr && source->getLengthInSamples() > 0)
+        {
+            const auto reader = source->getReader();
+            const auto length = source->getLengthInSamples();
+
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                const auto start = length * bin / numBins;
+                const auto end = juce::jmax (start + 1, length * (bin + 1) / numBins);
+                const auto step = juce::jmax ((juce::int64) 1, (end - start) / maxProbesPerBin);
+                float low = 0.0f, high = 0.0f;
+
+                for (auto i = start; i < end; i += step)
+                {
+                    for (int ch : { 0, reader.rightChannel })
+                    {
+                        const float value = reader.sample (ch, i);
+                        low = juce::jmin (low, value);
+                        high = juce::jmax (high, value);
+                    }
+                }
+
+                newMin[(size_t) bin] = low;
+                newMax[(size_t) bin] = high;
+            }
+        }
+
+        {
+            const juce::ScopedLock sl (lock);
+            std::swap (minimum, newMin);
+            std::swap (maximum, newMax);
+        }
+
+        version.fetch_add (1, std::memory_order_release);
+    }
+
+    /**
+     Returns a number that changes every time the outline is rebuilt. Safe from any thread.
+     */
+    int getVersion() const
+    {
+        return version.load (std::memory_order_acquire);
+    }
+
+    /**
+     copies the outline, numBins values each - message thread
+     @param mins std::vector<float>&
+     @param maxs std::vector<float>&
+     */
+    void copyTo (std::vector<float>& mins, std::vector<float>& maxs) const
+    {
+        const juce::ScopedLock sl (lock);
+        mins = minimum;
+        maxs = maximum;
+    }
+
+private:
+    static constexpr juce::int64 maxProbesPerBin = 64;
+
+    juce::CriticalSection lock;
+    std::vector<float> minimum = std::vector<float> ((size_t) numBins, 0.0f);
+    std::vector<float> maximum = std::vector<float> ((size_t) numBins, 0.0f);
+    std::atomic<int> version { 0 };
+};
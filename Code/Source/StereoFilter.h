@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    StereoFilter.h
+    Created: 22 Oct 2026 10:07:36am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class StereoFilter - the output filter, both channels in one SIMD register
+
+ A biquad in transposed direct form II. Left and right sit in lanes 0 and 1 of one
+ juce::dsp::SIMDRegister, so every multiply-add of the recursion serves both channels; the other
+ lanes idle. The coefficients are the ones juce::IIRCoefficients builds (makeLowPass, makeBandPass,
+ makeHighPass), so a settled filter sounds as before.
+
+ The cutoff glides in octaves on a ControlRamp, stepped once per control tick. The coefficients are
+ only worked out again for a tick in which the cutoff moved, or after the type or resonance changed;
+ a filter that is left alone costs the recursion and nothing else.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "GrainParameters.h"
+
+class StereoFilter
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+
+    enum Type
+    {
+        lowPass = 0,    // in the order of the "FilterType" choice
+        bandPass,
+        highPass
+    };
+
+    /**
+     @param sampleRate double
+     @param cutoffHz float - where the cutoff starts, so the first block doesn't sweep into place
+     */
+    void prepare (double sampleRate, float cutoffHz)
+    {
+        currentSampleRate = sampleRate;
+        targetOctave = toOctave (cutoffHz);
+        cutoffRamp.reset (sampleRate, cutoffGlideSeconds, targetOctave);
+        coefficientsDirty = true;
+        reset();
+    }
+
+    void reset()
+    {
+        s1 = Vec::expand (0.0f);
+        s2 = Vec::expand (0.0f);
+    }
+
+    /**
+     takes the block's parameter values - audio thread, once per block
+     @param type int - Type
+     @param cutoffHz float
+     @param resonance float - Q
+     */
+    void setParameters (int type, float cutoffHz, float resonance)
+    {
+        if (type != filterType || resonance != q)
+        {
+            filterType = type;
+            q = resonance;
+            coefficientsDirty = true;
+        }
+
+        targetOctave = toOctave (cutoffHz);
+    }
+
+    /**
+     filters the first two channels of the buffer in place
+     @param buffer juce::AudioBuffer<float>&
+     */
+    void process (juce::AudioBuffer<float>& buffer)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        const int numSamples = buffer.getNumSamples();
+        if (buffer.getNumChannels() == 0 || numSamples == 0)
+            return;
+
+        float* left = buffer.getWritePointer (0);
+        float* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer (1) : nullptr;
+
+        alignas (Vec::SIMDRegisterSize) float frame[lanes] {};
+
+        for (int tickStart = 0; tickStart < numSamples; tickStart += controlInterval)
+        {
+            const int tickLength = juce::jmin (controlInterval, numSamples - tickStart);
+            cutoffRamp.advance (targetOctave, tickLength);
+
+            // the whole tick uses the cutoff its ramp reaches at the end of it
+            const float octave = cutoffRamp.at (tickLength - 1);
+            if (coefficientsDirty || octave != coefficientOctave)
+                updateCoefficients (octave);
+
+            for (int i = tickStart; i < tickStart + tickLength; ++i)
+            {
+                frame[0] = left[i];
+                frame[1] = right != nullptr ? right[i] : 0.0f;
+
+                const auto x = Vec::fromRawArray (frame);
+                const auto y = b0 * x + s1;
+                s1 = b1 * x - a1 * y + s2;
+                s2 = b2 * x - a2 * y;
+
+                y.copyToRawArray (frame);
+                left[i] = frame[0];
+                if (right != nullptr)
+                    right[i] = frame[1];
+            }
+        }
+    }
+
+private:
+    static float toOctave (float cutoffHz)
+    {
+        return std::log2 (juce::jmax (1.0f, cutoffHz));
+    }
+
+    /**
+     the juce::IIRCoefficients formulas for the current type and Q, at a cutoff given in octaves
+     @param octave float - log2 of the cutoff in Hz
+     */
+    void updateCoefficients (float octave)
+    {
+        coefficientOctave = octave;
+        coefficientsDirty = false;
+
+        // above about 0.45 of the sample rate the bilinear transform runs out of room
+        const double frequency = juce::jlimit (10.0, currentSampleRate * 0.45, std::exp2 ((double) octave));
+        const double Q = juce::jmax (0.01, (double) q);
+        const double w = juce::MathConstants<double>::pi * frequency / currentSampleRate;
+
+        double c0, c1, c2, d1, d2;
+
+        if (filterType == highPass)
+        {
+            const double n = std::tan (w);
+            const double nSquared = n * n;
+            const double c = 1.0 / (1.0 + n / Q + nSquared);
+            c0 = c;
+            c1 = -2.0 * c;
+            c2 = c;
+            d1 = 2.0 * c * (nSquared - 1.0);
+            d2 = c * (1.0 - n / Q + nSquared);
+        }
+        else
+        {
+            const double n = 1.0 / std::tan (w);
+            const double nSquared = n * n;
+            const double c = 1.0 / (1.0 + n / Q + nSquared);
+            d1 = 2.0 * c * (1.0 - nSquared);
+            d2 = c * (1.0 - n / Q + nSquared);
+
+            if (filterType == bandPass)
+            {
+                c0 = c * n / Q;
+                c1 = 0.0;
+                c2 = -c * n / Q;
+            }
+            else
+            {
+                c0 = c;
+                c1 = 2.0 * c;
+                c2 = c;
+            }
+        }
+
+        b0 = Vec::expand ((float) c0);
+        b1 = Vec::expand ((float) c1);
+        b2 = Vec::expand ((float) c2);
+        a1 = Vec::expand ((float) d1);
+        a2 = Vec::expand ((float) d2);
+    }
+
+    static constexpr int controlInterval = 32;          // samples per control tick, as in GrainVoice
+    static constexpr double cutoffGlideSeconds = 0.05;
+
+    double currentSampleRate = 44100.0;
+    int filterType = lowPass;
+    float q = 1.0f;
+    float targetOctave = 0.0f;
+    float coefficientOctave = 0.0f;
+    bool coefficientsDirty = true;
+    ControlRamp cutoffRamp;
+
+    // coefficients in every lane, and the two state registers - lane 0 left, lane 1 right
+    Vec b0 = Vec::expand (1.0f), b1 = Vec::expand (0.0f), b2 = Vec::expand (0.0f);
+    Vec a1 = Vec::expand (0.0f), a2 = Vec::expand (0.0f);
+    Vec s1 = Vec::expand (0.0f), s2 = Vec::expand (0.0f);
+};
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    VoiceWorkerPool.h
+    Created: 17 Oct 2026 10:05:44am
+    Author:  Shreya Gupta
+
+  ==============================================================================
+*/
+
+/**
+ @class VoiceWorkerPool - a small pool of realtime-priority threads that render voices in parallel
+
+ The audio thread hands over a batch of jobs with run(), works on the batch itself as well,
+ and returns once every job is finished. Jobs are claimed with a compare-and-swap on a single
+ atomic word holding the batch generation, the job count and the next job index, so a worker
+ waking up late can never pick up a job from the wrong batch. Nothing here allocates or takes a
+ lock while a batch runs, apart from waking sleeping workers through their WaitableEvent.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdint>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+class VoiceWorkerPool
+{
+public:
+    using JobFunction = void (*) (void* context, int jobIndex);
+
+    ~VoiceWorkerPool()
+    {
+        stop();
+    }
+
+    /**
+     starts the worker threads - called from prepareToPlay, never from the audio thread
+     @param numWorkers int - threads besides the audio thread
+     @param samplesPerBlock int - used to tell the OS how much work to expect per audio callback
+     @param sampleRate double
+     */
+    void start (int numWorkers, int samplesPerBlock, double sampleRate)
+    {
+        stop();
+
+        auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime (samplesPerBlock, sampleRate);
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto* worker = workers.add (new Worker (*this, i));
+            worker->startRealtimeThread (options);
+        }
+    }
+
+    void stop()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        for (auto* worker : workers)
+            worker->wake.signal();
+
+        workers.clear(); // ~Worker waits for the thread to finish
+    }
+
+    int getNumWorkers() const
+    {
+        return workers.size();
+    }
+
+    /**
+     runs job (context, i) for every i in [0, numJobs) on the workers and the calling thread,
+     and returns when all of them have finished
+     @param job JobFunction
+     @param context void*
+     @param numJobs int - at most 0xffff
+     */
+    void run (JobFunction job, void* context, int numJobs)
+    {
+        jobFunction = job;
+        jobContext = context;
+        jobsDone.store (0, std::memory_order_relaxed);
+
+        ++generation;
+        work.store ((uint64_t (generation) << 32) | (uint64_t (numJobs) << 16), std::memory_order_release);
+
+        for (auto* worker : workers)
+            worker->wake.signal();
+
+        // the audio thread takes jobs too, so it only ever waits for jobs already running on a worker
+        drain();
+
+        while (jobsDone.load (std::memory_order_acquire) < numJobs)
+            spinPause();
+    }
+
+private:
+    struct Worker : public juce::Thread
+    {
+        Worker (VoiceWorkerPool& p, int index) : juce::Thread ("Grain voice worker " + juce::String (index)), pool (p) {}
+
+        ~Worker() override
+        {
+            stopThread (1000);
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                wake.wait (100);
+                pool.drain();
+            }
+        }
+
+        VoiceWorkerPool& pool;
+        juce::WaitableEvent wake;
+    };
+
+    /**
+     claims and runs jobs of the current batch until there are none left
+     */
+    void drain()
+    {
+        auto current = work.load (std::memory_order_acquire);
+
+        for (;;)
+        {
+            const auto index = int (current & 0xffff);
+            const auto numJobs = int ((current >> 16) & 0xffff);
+
+            if (index >= numJobs)
+                return;
+
+            if (work.compare_exchange_weak (current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                jobFunction (jobContext, index);
+                jobsDone.fetch_add (1, std::memory_order_release);
+                current = work.load (std::memory_order_acquire);
+            }
+        }
+    }
+
+    static void spinPause()
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && JUCE_CLANG
+        __builtin_arm_yield();
+       #endif
+    }
+
+    juce::OwnedArray<Worker> workers;
+
+    // batch description, written by the audio thread before the batch is published
+    JobFunction jobFunction = nullptr;
+    void* jobContext = nullptr;
+    uint32_t generation = 0;
+
+    // kept on their own cache lines: every worker hammers these while a batch runs
+    alignas (64) std::atomic<uint64_t> work { 0 };
+    alignas (64) std::atomic<int> jobsDone { 0 };
+};